@@ -157,9 +157,14 @@ zzt_qrcode_detect_and_decode_pixels_jni(zzt_qrcode_detector_h detector, unsigned
         return 0;
     }
 
+    // Only the Y plane of the YUV formats is read, so they are validated like gray data.
     int bpp = 1;
     switch (format) {
         case ZZT_QRCODE_PIXEL_GRAY:
+        case ZZT_QRCODE_PIXEL_NV21:
+        case ZZT_QRCODE_PIXEL_NV12:
+        case ZZT_QRCODE_PIXEL_I420:
+        case ZZT_QRCODE_PIXEL_YV12:
             bpp = 1;
             break;
         case ZZT_QRCODE_PIXEL_RGB:
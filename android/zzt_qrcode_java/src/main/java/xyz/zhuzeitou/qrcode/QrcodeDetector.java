@@ -48,6 +48,22 @@ public class QrcodeDetector implements AutoCloseable {
          * 4 channels ABGR
          */
         ABGR,
+        /**
+         * YUV 4:2:0 semi-planar (Y plane then VU), only the Y plane is read
+         */
+        NV21,
+        /**
+         * YUV 4:2:0 semi-planar (Y plane then UV), only the Y plane is read
+         */
+        NV12,
+        /**
+         * YUV 4:2:0 planar (Y, U, V planes), only the Y plane is read
+         */
+        I420,
+        /**
+         * YUV 4:2:0 planar (Y, V, U planes), only the Y plane is read
+         */
+        YV12,
     }
 
     /**
@@ -21,8 +21,12 @@ extern "C" {
  */
 struct zzt_qrcode_detector_t;
 struct zzt_qrcode_result_t;
+struct zzt_qrcode_ticket_t;
 typedef struct zzt_qrcode_detector_t *zzt_qrcode_detector_h;
 typedef struct zzt_qrcode_result_t *zzt_qrcode_result_h;
+typedef struct zzt_qrcode_ticket_t *zzt_qrcode_ticket_h;
+typedef struct zzt_qrcode_stream_t *zzt_qrcode_stream_h;
+typedef struct zzt_qrcode_cancel_token_t *zzt_qrcode_cancel_token_h;
 
 #ifdef _WIN32
 #ifdef ZZT_QRCODE_EXPORT
@@ -40,6 +44,8 @@ typedef struct zzt_qrcode_result_t *zzt_qrcode_result_h;
 
 /**
  * Pixel format enum
+ * For the YUV formats only the Y plane at the start of the buffer is read, and stride is the Y plane row stride.
+ * The chroma planes may follow in any layout and are never touched, so no color conversion happens at all.
  */
 typedef enum {
     ZZT_QRCODE_PIXEL_GRAY = 0,  // Single channel Gray
@@ -48,9 +54,141 @@ typedef enum {
     ZZT_QRCODE_PIXEL_RGBA = 3,  // 4 channels RGBA
     ZZT_QRCODE_PIXEL_BGRA = 4,  // 4 channels BGRA
     ZZT_QRCODE_PIXEL_ARGB = 5,  // 4 channels ARGB
-    ZZT_QRCODE_PIXEL_ABGR = 6   // 4 channels ABGR
+    ZZT_QRCODE_PIXEL_ABGR = 6,  // 4 channels ABGR
+    ZZT_QRCODE_PIXEL_NV21 = 7,  // YUV 4:2:0 semi-planar, Y plane then interleaved VU
+    ZZT_QRCODE_PIXEL_NV12 = 8,  // YUV 4:2:0 semi-planar, Y plane then interleaved UV
+    ZZT_QRCODE_PIXEL_I420 = 9,  // YUV 4:2:0 planar, Y plane then U plane then V plane
+    ZZT_QRCODE_PIXEL_YV12 = 10  // YUV 4:2:0 planar, Y plane then V plane then U plane
 } zzt_qrcode_pixel_format_t;
 
+/**
+ * Image source type enum, used by batch decoding
+ */
+typedef enum {
+    ZZT_QRCODE_IMAGE_DATA = 0,    // Encoded image file data in memory (JPEG, PNG, etc.)
+    ZZT_QRCODE_IMAGE_PIXELS = 1,  // Raw pixel data
+} zzt_qrcode_image_type_t;
+
+/**
+ * Image descriptor, used by batch decoding
+ */
+typedef struct {
+    zzt_qrcode_image_type_t type;      // Image source type
+    const unsigned char *data;         // Encoded image data or raw pixel data pointer
+    int data_len;                      // Encoded image data length (bytes), ignored for pixels
+    zzt_qrcode_pixel_format_t format;  // Pixel format, ignored for encoded image data
+    int width;                         // Image width (pixels), ignored for encoded image data
+    int height;                        // Image height (pixels), ignored for encoded image data
+    int stride;                        // Image row stride (bytes), 0 for auto, ignored for encoded image data
+} zzt_qrcode_image_t;
+
+/**
+ * Per-call options, see zzt_qrcode_detect_and_decode_image
+ */
+typedef struct {
+    int timeout_ms;                          // Time budget of the call (milliseconds), negative for no limit
+    zzt_qrcode_cancel_token_h cancel_token;  // Optional cancel token, may be NULL
+} zzt_qrcode_call_options_t;
+
+/**
+ * Header at the start of a buffer filled by zzt_qrcode_export_results
+ */
+typedef struct {
+    int size;   // Number of bytes used in the buffer
+    int count;  // Number of QR codes, a table of this many zzt_qrcode_export_entry_t follows the header
+} zzt_qrcode_export_header_t;
+
+/**
+ * Offset table entry of one QR code in a buffer filled by zzt_qrcode_export_results.
+ * Offsets are in bytes from the start of the buffer.
+ */
+typedef struct {
+    int text_offset;       // Offset of the UTF-8 text, null terminated
+    int text_size;         // Text length (bytes), excluding the null terminator
+    int raw_bytes_offset;  // Offset of the raw data codewords
+    int raw_bytes_size;    // Raw data length (bytes)
+    int points_offset;     // Offset of the vertex coordinate array (float x0, y0, x1, y1, ...)
+    int points_count;      // Number of float values in the vertex coordinate array (usually 8)
+} zzt_qrcode_export_entry_t;
+
+/**
+ * Binarizer enum, also the index into the per-binarizer arrays of zzt_qrcode_stats_t
+ */
+typedef enum {
+    ZZT_QRCODE_BINARIZER_HYBRID = 0,              // Hybrid (local block) binarizer
+    ZZT_QRCODE_BINARIZER_FAST_WINDOW = 1,         // Fast window binarizer
+    ZZT_QRCODE_BINARIZER_SIMPLE_ADAPTIVE = 2,     // Simple adaptive binarizer
+    ZZT_QRCODE_BINARIZER_ADAPTIVE_THRESHOLD = 3,  // Adaptive threshold mean binarizer
+} zzt_qrcode_binarizer_t;
+
+#define ZZT_QRCODE_BINARIZER_COUNT 4
+#define ZZT_QRCODE_MAX_SCALES 8
+
+/**
+ * Detector options, see zzt_qrcode_create_detector_ex. Initialize with zzt_qrcode_init_options first so that
+ * unset fields keep their defaults.
+ */
+typedef struct {
+    int use_nn_detector;                              // Non-zero to run the CNN detector, otherwise the whole
+                                                      // image is decoded as one candidate (default 1)
+    int use_super_resolution;                         // Non-zero to upscale small codes with the super
+                                                      // resolution model, otherwise bicubic (default 1)
+    zzt_qrcode_binarizer_t binarizers[ZZT_QRCODE_BINARIZER_COUNT];  // Binarizers to try, in order
+    int binarizer_count;                              // Number of binarizers used, 0 for all four (default 0)
+    float scales[ZZT_QRCODE_MAX_SCALES];              // Scales to try for every candidate, in order
+    int scale_count;                                  // Number of scales used, 0 for the size based default
+                                                      // ladder (default 0)
+    float detector_target_area;                       // Area (pixels) images are resized to before the CNN
+                                                      // detector (default 160000)
+    int num_threads;                                  // Threads per CNN inference (default 1)
+    int decode_threads;                               // Threads decoding the detected candidates of one image,
+                                                      // the caller plus workers of the shared pool, see
+                                                      // zzt_qrcode_set_worker_threads. 0 for one per pool thread
+                                                      // (default 1)
+    int speculative_scales;                           // Non-zero to try all scales of a candidate at once on
+                                                      // the decode threads and cancel the remaining ones on the
+                                                      // first success, lowering the worst case latency at the
+                                                      // cost of CPU time. Needs decode_threads != 1 (default 0)
+    int parallel_binarizers;                          // Non-zero to run the binarizers of every decode attempt at
+                                                      // once on the decode threads, the first success in order
+                                                      // cancels the later ones. Needs decode_threads != 1
+                                                      // (default 0)
+    int adaptive_binarizers;                          // Non-zero to learn which binarizer succeeds most cheaply
+                                                      // per image size and try it first, see
+                                                      // zzt_qrcode_save_binarizer_stats (default 0)
+    int adaptive_scales;                              // Non-zero to order the scales of every candidate by its
+                                                      // estimated module size and by the scales that succeeded
+                                                      // on similar codes. Configured scales are reordered
+                                                      // but never added to (default 0)
+    int max_results;                                  // Stop decoding once this many codes are found, 0 for no
+                                                      // limit. With decode_threads != 1 the codes returned may
+                                                      // vary when the image holds more (default 0)
+} zzt_qrcode_options_t;
+
+/**
+ * Per-stage timings and counters, see zzt_qrcode_set_stats_enabled.
+ * Times are in milliseconds. Every field is a sum, so a per-call struct has calls == 1 and the detector struct
+ * holds the totals over all calls since the last reset.
+ * Binarizer arrays are indexed 0 Hybrid, 1 FastWindow, 2 SimpleAdaptive, 3 AdaptiveThreshold.
+ */
+typedef struct {
+    int calls;                                             // Decode calls
+    int successful_calls;                                  // Calls that decoded at least one QR code
+    int codes;                                             // Decoded QR codes
+    int candidates;                                        // Candidate regions found by the detector
+    int scale_attempts;                                    // Decode attempts over all candidates and scales
+    int tracked_calls;                                     // Stream calls served from the previous frame's codes
+    int binarizer_attempts[ZZT_QRCODE_BINARIZER_COUNT];    // Attempts per binarizer
+    int binarizer_successes[ZZT_QRCODE_BINARIZER_COUNT];   // Successful attempts per binarizer
+    double binarizer_ms[ZZT_QRCODE_BINARIZER_COUNT];       // Time per binarizer, including finder and decoder
+    double total_ms;                                       // Whole decode, excluding image loading
+    double detect_ms;                                      // SSD detector inference
+    double crop_scale_ms;                                  // Candidate cropping and plain rescaling
+    double sr_ms;                                          // Super resolution upscaling
+    double finder_ms;                                      // Finder and alignment pattern search and sampling
+    double decoder_ms;                                     // Bit stream decoding and error correction
+} zzt_qrcode_stats_t;
+
 /**
  * Error code enum
  */
@@ -62,14 +200,40 @@ typedef enum {
     ZZT_QRCODE_ERROR_DECODE_FAILED = -4,     // Image decode failed
     ZZT_QRCODE_ERROR_INVALID_ARGUMENT = -5,  // Invalid argument (e.g. null pointer or invalid size)
     ZZT_QRCODE_ERROR_OUT_OF_MEMORY = -6,     // Out of memory
+    ZZT_QRCODE_ERROR_PENDING = -7,           // Asynchronous request has not finished yet
+    ZZT_QRCODE_ERROR_TIMEOUT = -8,           // Time budget ran out, the result holds the codes found so far
+    ZZT_QRCODE_ERROR_CANCELLED = -9,         // Cancelled, the result holds the codes found so far
 } zzt_qrcode_error_t;
 
+/**
+ * Completion callback of the asynchronous API, invoked on a worker thread.
+ * @param error Error code of the request, same values as the synchronous functions return.
+ * @param result Result list handle, NULL on failure. Owned by the callback, must be released with
+ *               zzt_qrcode_release_result.
+ * @param user_data User data pointer passed when submitting the request.
+ */
+typedef void (*zzt_qrcode_callback_t)(zzt_qrcode_error_t error, zzt_qrcode_result_h result, void *user_data);
+
 /**
  * Create a QR code detector instance.
  * @return Returns the detector handle, or NULL if failed.
  */
 ZZT_QRCODE_API zzt_qrcode_detector_h zzt_qrcode_create_detector();
 
+/**
+ * Fill the options with their defaults, which match zzt_qrcode_create_detector.
+ * @param options Options to initialize.
+ */
+ZZT_QRCODE_API void zzt_qrcode_init_options(zzt_qrcode_options_t *options);
+
+/**
+ * Create a QR code detector instance with the given options. Models of disabled stages are not loaded.
+ * @param options Detector options, NULL for the defaults.
+ * @return Returns the detector handle, or NULL if failed or the options are invalid (unknown binarizer, scale not
+ *         positive, count out of range, non-positive target area or thread count, negative decode threads).
+ */
+ZZT_QRCODE_API zzt_qrcode_detector_h zzt_qrcode_create_detector_ex(const zzt_qrcode_options_t *options);
+
 /**
  * Release the QR code detector instance.
  * @param detector Detector handle.
@@ -112,14 +276,18 @@ ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_detect_and_decode_path_u16(zzt_qrco
  * Process raw pixel data directly.
  * @param detector Detector handle.
  * @param pixels Pixel data pointer. The data will be automatically converted to grayscale for processing.
- * @param format Pixel format, supports GRAY/RGB/BGR/RGBA/BGRA.
+ *               GRAY data with contiguous rows (stride 0 or equal to width) is read in place without any copy;
+ *               a larger stride only copies the rows. The buffer must stay unchanged until this call returns.
+ *               The luma plane of the YUV formats is handled exactly like GRAY data.
+ * @param format Pixel format, supports GRAY/RGB/BGR/RGBA/BGRA/ARGB/ABGR and NV21/NV12/I420/YV12.
  * @param width Image width (pixels).
  * @param height Image height (pixels).
- * @param stride Image row stride (bytes). If 0, it is automatically calculated based on width and format.
+ * @param stride Image row stride (bytes), the Y plane row stride for YUV formats. If 0, it is automatically
+ *               calculated based on width and format.
  * @param out_result Pointer to the output result list handle. Must be released with zzt_qrcode_release_result after use.
  * @return ZZT_QRCODE_OK Success
  *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
- *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer or invalid size)
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer, invalid size or stride)
  */
 ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_detect_and_decode_pixels(zzt_qrcode_detector_h detector,
                                                                     const unsigned char *pixels,
@@ -127,6 +295,175 @@ ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_detect_and_decode_pixels(zzt_qrcode
                                                                     int height, int stride,
                                                                     zzt_qrcode_result_h *out_result);
 
+/**
+ * Detect and decode a batch of images with a single call.
+ * The detector handle is looked up once and scratch buffers are shared across the whole batch, which is cheaper
+ * than calling the single image functions in a loop.
+ * @param detector Detector handle.
+ * @param images Array of image descriptors, either encoded image data or raw pixel data.
+ * @param image_count Number of images in the array.
+ * @param out_results Output array of result list handles, must hold image_count elements. Each handle is NULL if
+ *                    the corresponding image failed, otherwise it must be released with zzt_qrcode_release_result.
+ * @param out_errors Optional output array of per-image error codes, must hold image_count elements. May be NULL.
+ * @return ZZT_QRCODE_OK The batch was processed, check out_errors for the status of each image
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer or invalid count)
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_detect_and_decode_batch(zzt_qrcode_detector_h detector,
+                                                                   const zzt_qrcode_image_t *images, int image_count,
+                                                                   zzt_qrcode_result_h *out_results,
+                                                                   zzt_qrcode_error_t *out_errors);
+
+/**
+ * Detect and decode a single image with a time budget and/or a cancel token.
+ * The budget and the token are checked between pipeline stages (detector, each scale of each candidate, each
+ * binarizer, the inverted image pass and the reader's retries), so a call overruns the budget by at most one stage.
+ * @param detector Detector handle.
+ * @param image Image descriptor, either encoded image data or raw pixel data. Decoding encoded data is not
+ *              covered by the budget.
+ * @param call_options Optional call options, NULL for no limit.
+ * @param out_result Pointer to the output result list handle. Also set on ZZT_QRCODE_ERROR_TIMEOUT and
+ *                   ZZT_QRCODE_ERROR_CANCELLED, holding the codes decoded before the call stopped. Must be released
+ *                   with zzt_qrcode_release_result after use.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_TIMEOUT The time budget ran out, out_result holds partial results
+ *         ZZT_QRCODE_ERROR_CANCELLED The cancel token was cancelled, out_result holds partial results
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector or cancel token handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer, invalid size or stride)
+ *         ZZT_QRCODE_ERROR_DECODE_FAILED Encoded image data could not be decoded
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_detect_and_decode_image(zzt_qrcode_detector_h detector,
+                                                                   const zzt_qrcode_image_t *image,
+                                                                   const zzt_qrcode_call_options_t *call_options,
+                                                                   zzt_qrcode_result_h *out_result);
+
+/**
+ * Create a cancel token. A token may be shared by any number of calls, cancelling it stops all of them.
+ * @return Cancel token handle. Must be released with zzt_qrcode_release_cancel_token after use.
+ */
+ZZT_QRCODE_API zzt_qrcode_cancel_token_h zzt_qrcode_create_cancel_token();
+
+/**
+ * Cancel every call using the token, now and later. Safe to call from any thread.
+ * @param token Cancel token handle.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid cancel token handle
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_cancel(zzt_qrcode_cancel_token_h token);
+
+/**
+ * Release the cancel token instance. Calls still using the token keep it alive until they return.
+ * @param token Cancel token handle.
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_release_cancel_token(zzt_qrcode_cancel_token_h token);
+
+/**
+ * Create a stream session for decoding consecutive video frames with a detector.
+ * The regions of the codes found in the previous frame are decoded first, which skips the CNN detector and the
+ * search over the whole frame. The full pipeline only runs when nothing is tracked, when fewer codes than tracked
+ * are found again, or periodically to pick up new codes.
+ * @param detector Detector handle, kept alive by the stream until it is released.
+ * @param refresh_interval Run the full pipeline at least every this many frames, 0 to run it only when tracking is
+ *                         lost.
+ * @return Stream handle, NULL if the detector handle is invalid or refresh_interval is negative.
+ *         Must be released with zzt_qrcode_release_stream after use.
+ */
+ZZT_QRCODE_API zzt_qrcode_stream_h zzt_qrcode_create_stream(zzt_qrcode_detector_h detector, int refresh_interval);
+
+/**
+ * Release the stream session instance.
+ * @param stream Stream handle.
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_release_stream(zzt_qrcode_stream_h stream);
+
+/**
+ * Forget the tracked codes, the next frame runs the full pipeline. Call this on a scene cut or camera switch.
+ * @param stream Stream handle.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid stream handle
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_reset_stream(zzt_qrcode_stream_h stream);
+
+/**
+ * Decode the next frame of a stream. Same pixel handling as zzt_qrcode_detect_and_decode_pixels.
+ * Frames of one stream are decoded one at a time, concurrent calls on the same stream are serialized.
+ * @param stream Stream handle.
+ * @param pixels Pixel data pointer.
+ * @param format Pixel format.
+ * @param width Image width (pixels).
+ * @param height Image height (pixels).
+ * @param stride Image row stride (bytes). If 0, it is automatically calculated based on width and format.
+ * @param out_result Pointer to the output result list handle. Must be released with zzt_qrcode_release_result after use.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid stream handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer, invalid size or stride)
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_stream_decode_pixels(zzt_qrcode_stream_h stream,
+                                                                const unsigned char *pixels,
+                                                                zzt_qrcode_pixel_format_t format, int width,
+                                                                int height, int stride,
+                                                                zzt_qrcode_result_h *out_result);
+
+/**
+ * Set the number of threads of the library-owned worker pool used by the zzt_qrcode_submit_* functions.
+ * Threads are started lazily on the first submitted request. Pending requests are kept across a resize.
+ * Must not be called from a completion callback.
+ * @param thread_count Number of worker threads, 0 for one thread per hardware core (default).
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Negative thread count, or called from a worker thread
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_set_worker_threads(int thread_count);
+
+/**
+ * Asynchronous versions of the zzt_qrcode_detect_and_decode_* functions. The request is queued onto the worker
+ * pool and the function returns immediately. The result is delivered through the callback if one is given,
+ * otherwise it is kept in the ticket until collected with zzt_qrcode_wait_ticket.
+ * Input data is copied (encoded data, path) or converted to grayscale (pixels) before returning, so the caller's
+ * buffers may be reused right away. A detector may serve several requests at the same time.
+ * Requests still queued when the library unloads complete with ZZT_QRCODE_ERROR_CANCELLED and no result.
+ * @param detector Detector handle.
+ * @param callback Optional completion callback, may be NULL when out_ticket is given.
+ * @param user_data User data pointer passed to the callback.
+ * @param out_ticket Optional pointer to the output ticket handle, may be NULL when callback is given.
+ *                   Must be released with zzt_qrcode_release_ticket after use.
+ * @return ZZT_QRCODE_OK Request queued
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument, or both callback and out_ticket are NULL
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_submit_data(zzt_qrcode_detector_h detector, const unsigned char *data,
+                                                       int data_len, zzt_qrcode_callback_t callback,
+                                                       void *user_data, zzt_qrcode_ticket_h *out_ticket);
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_submit_path_u8(zzt_qrcode_detector_h detector, const char8_t *path,
+                                                          zzt_qrcode_callback_t callback, void *user_data,
+                                                          zzt_qrcode_ticket_h *out_ticket);
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_submit_path_u16(zzt_qrcode_detector_h detector, const char16_t *path,
+                                                           zzt_qrcode_callback_t callback, void *user_data,
+                                                           zzt_qrcode_ticket_h *out_ticket);
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_submit_pixels(zzt_qrcode_detector_h detector,
+                                                         const unsigned char *pixels,
+                                                         zzt_qrcode_pixel_format_t format, int width, int height,
+                                                         int stride, zzt_qrcode_callback_t callback,
+                                                         void *user_data, zzt_qrcode_ticket_h *out_ticket);
+
+/**
+ * Wait for an asynchronous request to finish.
+ * @param ticket Ticket handle.
+ * @param timeout_ms Maximum time to wait in milliseconds, 0 to poll without blocking, negative to wait forever.
+ * @param out_result Optional pointer to the output result list handle. The result can be taken only once and must be
+ *                   released with zzt_qrcode_release_result. NULL if the result was delivered to a callback.
+ * @return ZZT_QRCODE_ERROR_PENDING Request not finished within the timeout
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid ticket handle
+ *         Otherwise the error code of the finished request
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_wait_ticket(zzt_qrcode_ticket_h ticket, int timeout_ms,
+                                                       zzt_qrcode_result_h *out_result);
+
+/**
+ * Release the ticket instance. A pending request still runs, its uncollected result is released automatically.
+ * @param ticket Ticket handle.
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_release_ticket(zzt_qrcode_ticket_h ticket);
+
 /**
  * Release the result list instance.
  * @param result Result list handle.
@@ -170,6 +507,88 @@ ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_get_result_text(zzt_qrcode_result_h
 ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_get_result_points(zzt_qrcode_result_h result, int index, float *output_point,
                                                              int *buffer_size);
 
+/**
+ * Export every QR code in the result list into one contiguous buffer with a single call.
+ * The buffer starts with a zzt_qrcode_export_header_t, followed by one zzt_qrcode_export_entry_t per QR code,
+ * followed by the vertex coordinates, raw bytes and texts the entries point to.
+ * @param result Result list handle.
+ * @param buffer Output buffer pointer, must be aligned to at least 4 bytes. If NULL, only returns the required size.
+ * @param buffer_size Input/Output parameter. Input indicates the buffer size (bytes), output returns the actual
+ *                    required size.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid result handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null buffer_size)
+ *         ZZT_QRCODE_ERROR_BUFFER_TOO_SMALL Buffer too small, required size will be written to buffer_size
+ *         ZZT_QRCODE_ERROR_OUT_OF_MEMORY The results do not fit in a buffer addressable by int offsets
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_export_results(zzt_qrcode_result_h result, void *buffer,
+                                                          int *buffer_size);
+
+/**
+ * Enable or disable stats collection for a detector. Disabled by default, in which case no stage is timed.
+ * @param detector Detector handle.
+ * @param enabled Non-zero to enable.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_set_stats_enabled(zzt_qrcode_detector_h detector, int enabled);
+
+/**
+ * Get the stats of the call that produced a result list. All zero if stats were disabled at that time.
+ * @param result Result list handle.
+ * @param out_stats Output stats.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid result handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer)
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_get_result_stats(zzt_qrcode_result_h result,
+                                                            zzt_qrcode_stats_t *out_stats);
+
+/**
+ * Get the stats of a detector, summed over all calls made while stats were enabled since the last reset.
+ * @param detector Detector handle.
+ * @param out_stats Output stats.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Invalid argument (e.g. null pointer)
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_get_detector_stats(zzt_qrcode_detector_h detector,
+                                                              zzt_qrcode_stats_t *out_stats);
+
+/**
+ * Reset the aggregated stats of a detector to zero.
+ * @param detector Detector handle.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_reset_detector_stats(zzt_qrcode_detector_h detector);
+
+/**
+ * Save the binarizer observations of a detector created with adaptive_binarizers, as null terminated text.
+ * Load it into a later detector with zzt_qrcode_load_binarizer_stats to start from what was learned.
+ * @param detector Detector handle.
+ * @param output_text Output text buffer pointer. If NULL, only returns the required buffer size.
+ * @param buffer_size Input/Output parameter. Input indicates the buffer size, output returns the actual required
+ *                    size (including the null terminator \0).
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT The detector was not created with adaptive_binarizers
+ *         ZZT_QRCODE_ERROR_BUFFER_TOO_SMALL Buffer too small, required size will be written to buffer_size
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_save_binarizer_stats(zzt_qrcode_detector_h detector, char *output_text,
+                                                                int *buffer_size);
+
+/**
+ * Replace the binarizer observations of a detector created with adaptive_binarizers.
+ * @param detector Detector handle.
+ * @param text Null terminated text produced by zzt_qrcode_save_binarizer_stats.
+ * @return ZZT_QRCODE_OK Success
+ *         ZZT_QRCODE_ERROR_INVALID_HANDLE Invalid detector handle
+ *         ZZT_QRCODE_ERROR_INVALID_ARGUMENT Null or malformed text, or the detector was not created with
+ *                                           adaptive_binarizers
+ */
+ZZT_QRCODE_API zzt_qrcode_error_t zzt_qrcode_load_binarizer_stats(zzt_qrcode_detector_h detector, const char *text);
+
 #ifdef __cplusplus
 }
 #endif
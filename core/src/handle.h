@@ -1,14 +1,16 @@
 #ifndef ZZT_HANDLE_H
 #define ZZT_HANDLE_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace zzt::qrcode {
 template <typename HandleT, typename = void>
@@ -25,6 +27,12 @@ struct HandleTraits<HandleT, std::enable_if_t<std::is_pointer_v<HandleT>>> {
     static HandleT from_key(key_t handle) { return reinterpret_cast<HandleT>(handle); }
 };
 
+// Live handles are slots of a table that only grows, named by the slot index and a generation that changes every
+// time the slot is reused. Lookups take no lock: a reader publishes the slot in one of its thread's hazard pointers,
+// then checks the generation again. Release retires the slot and keeps it, with the object it owns, until no hazard
+// pointer names it. borrow pins the slot for a scope and writes only to the calling thread's own cache line, so
+// many threads can look up the same handle without contending. get also copies the owning shared_ptr, for callers
+// that keep the object beyond a call.
 template <typename T, typename HandleT = intptr_t>
 class Handle {
 public:
@@ -32,69 +40,260 @@ public:
     using traits = HandleTraits<handle_t>;
     using key_t = typename traits::key_t;
 
+    static constexpr int key_bits = sizeof(key_t) * 8;
+    static constexpr int index_bits = key_bits >= 64 ? 22 : 16;
+    static constexpr int chunk_bits = 10;
+    static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+    static constexpr std::size_t chunk_count = std::size_t(1) << (index_bits - chunk_bits);
+    static constexpr int hazards_per_thread = 4;
+
+private:
+    struct Slot {
+        // generation << 1 | live, 0 while the slot was never used
+        std::atomic<key_t> tag{0};
+        std::shared_ptr<T> owner;
+        key_t index = 0;
+    };
+
+public:
+    // An object pinned by a lookup, valid until the Borrowed goes out of scope, even when its handle is released
+    // meanwhile. Past hazards_per_thread nested borrows on one thread it holds a shared_ptr copy instead.
+    class Borrowed {
+    public:
+        Borrowed() = default;
+        Borrowed(Borrowed&& other) noexcept
+            : slot_(other.slot_), hazard_(other.hazard_), owner_(std::move(other.owner_)) {
+            other.slot_ = nullptr;
+            other.hazard_ = nullptr;
+        }
+        Borrowed(const Borrowed&) = delete;
+        Borrowed& operator=(const Borrowed&) = delete;
+        Borrowed& operator=(Borrowed&&) = delete;
+        ~Borrowed() {
+            if (hazard_ != nullptr) {
+                hazard_->store(nullptr, std::memory_order_release);
+            }
+        }
+
+        T* get() const { return slot_ != nullptr ? slot_->owner.get() : owner_.get(); }
+        T* operator->() const { return get(); }
+        T& operator*() const { return *get(); }
+        explicit operator bool() const { return get() != nullptr; }
+
+        std::shared_ptr<T> share() const { return slot_ != nullptr ? slot_->owner : owner_; }
+
+    private:
+        friend class Handle;
+        Slot* slot_ = nullptr;
+        std::atomic<Slot*>* hazard_ = nullptr;
+        std::shared_ptr<T> owner_;
+    };
+
     template <typename... Args>
     static handle_t create_handle(Args&&... args) {
         auto ptr = std::make_shared<T>(std::forward<Args>(args)...);
 
-        while (true) {
-            key_t index = generate_handle();
-            if (index != 0) {
-                std::unique_lock g(mutex());
-                auto [it, success] = handle_map().try_emplace(index, std::move(ptr));
-                if (success) {
-                    return traits::from_key(index);
+        Table& t = table();
+        std::lock_guard g(t.mutex);
+        Slot* slot = nullptr;
+        if (!t.free_slots.empty()) {
+            slot = t.free_slots.back();
+            t.free_slots.pop_back();
+        } else if (t.next_index < (key_t(1) << index_bits)) {
+            std::size_t chunk_index = static_cast<std::size_t>(t.next_index >> chunk_bits);
+            Slot* chunk = t.chunks[chunk_index].load(std::memory_order_relaxed);
+            if (chunk == nullptr) {
+                chunk = new Slot[chunk_size];
+                for (std::size_t i = 0; i < chunk_size; i++) {
+                    chunk[i].index = (key_t(chunk_index) << chunk_bits) | key_t(i);
                 }
+                t.chunks[chunk_index].store(chunk, std::memory_order_release);
             }
+            slot = &chunk[t.next_index & (chunk_size - 1)];
+            t.next_index++;
+        } else {
+            return traits::from_key(0);
         }
+
+        key_t generation;
+        do {
+            generation = t.next_generation++ & generation_mask;
+        } while (generation == 0 || generation == (slot->tag.load(std::memory_order_relaxed) >> 1) ||
+                 make_key(generation, slot->index) == 0);
+        slot->owner = std::move(ptr);
+        slot->tag.store(generation << 1 | 1, std::memory_order_release);
+        return traits::from_key(make_key(generation, slot->index));
     }
 
     static bool release_handle(handle_t handle) {
-        std::unique_lock g(mutex());
-        return handle_map().erase(traits::to_key(handle)) > 0;
+        key_t tag;
+        Slot* slot = find(traits::to_key(handle), tag);
+        if (slot == nullptr) {
+            return false;
+        }
+        std::vector<std::shared_ptr<T>> released;
+        {
+            Table& t = table();
+            std::lock_guard g(t.mutex);
+            key_t expected = tag;
+            if (!slot->tag.compare_exchange_strong(expected, tag & ~key_t(1), std::memory_order_seq_cst)) {
+                return false;
+            }
+            t.retired.push_back(slot);
+            reclaim(t, released);
+        }
+        // Objects are destroyed here, outside the table lock.
+        return true;
     }
 
-    static std::shared_ptr<T> get(handle_t handle) {
-        std::shared_lock g(mutex());
-        const auto key = traits::to_key(handle);
-        const auto& iter = handle_map().find(key);
-        if (iter == handle_map().end()) {
-            return nullptr;
+    static Borrowed borrow(handle_t handle) {
+        Borrowed borrowed;
+        key_t tag;
+        Slot* slot = find(traits::to_key(handle), tag);
+        if (slot == nullptr || slot->tag.load(std::memory_order_acquire) != tag) {
+            return borrowed;
+        }
+        std::atomic<Slot*>* hazard = free_hazard();
+        if (hazard == nullptr) {
+            Table& t = table();
+            std::lock_guard g(t.mutex);
+            if (slot->tag.load(std::memory_order_relaxed) == tag) {
+                borrowed.owner_ = slot->owner;
+            }
+            return borrowed;
         }
-        return iter->second;
+        // Either release sees the hazard before it reclaims the slot, or this sees the slot retired.
+        hazard->store(slot, std::memory_order_seq_cst);
+        if (slot->tag.load(std::memory_order_seq_cst) != tag) {
+            hazard->store(nullptr, std::memory_order_relaxed);
+            return borrowed;
+        }
+        borrowed.slot_ = slot;
+        borrowed.hazard_ = hazard;
+        return borrowed;
     }
 
+    static std::shared_ptr<T> get(handle_t handle) { return borrow(handle).share(); }
+
 private:
-    static key_t generate_handle() {
-        static std::atomic<key_t> next_handle = []() -> key_t {
-            auto now = std::chrono::steady_clock::now().time_since_epoch();
-            auto count = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
-            return static_cast<key_t>(count);
-        }();
-
-        constexpr int shift = 23;
-        constexpr key_t xor_key = (sizeof(key_t) == 8) ? static_cast<key_t>(0x9e3779b97f4a7c15ULL)
-                                                       : static_cast<key_t>(0x9e3779b9UL);
-
-        key_t raw = ++next_handle;
-
-#ifdef __cpp_lib_bitops
-        key_t shifted = std::rotl(raw, shift);
-#else
-        constexpr int bits = sizeof(key_t) * 8;
-        constexpr int s = shift % bits;
-        key_t shifted = s == 0 ? raw : ((raw << s) | (raw >> (bits - s)));
-#endif
-        return shifted ^ xor_key;
+    static constexpr key_t index_mask = (key_t(1) << index_bits) - 1;
+    static constexpr key_t generation_mask = (key_t(1) << (key_bits - index_bits - 1)) - 1;
+    static constexpr key_t xor_key = (sizeof(key_t) == 8) ? static_cast<key_t>(0x9e3779b97f4a7c15ULL)
+                                                          : static_cast<key_t>(0x9e3779b9UL);
+
+    struct alignas(64) HazardRecord {
+        std::array<std::atomic<Slot*>, hazards_per_thread> hazards{};
+        std::atomic<bool> active{false};
+        HazardRecord* next = nullptr;
+    };
+
+    struct Table {
+        std::array<std::atomic<Slot*>, chunk_count> chunks{};
+        std::atomic<HazardRecord*> records{nullptr};
+        // the rest only under mutex
+        std::mutex mutex;
+        key_t next_index = 0;
+        key_t next_generation = seed_generation();
+        std::vector<Slot*> free_slots;
+        std::vector<Slot*> retired;
+    };
+
+    static key_t seed_generation() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<key_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
     }
 
-    static std::unordered_map<key_t, std::shared_ptr<T>>& handle_map() {
-        static std::unordered_map<key_t, std::shared_ptr<T>> map;
-        return map;
+    // The generation goes in the high bits, scrambled so that handles do not read as small indices.
+    static key_t make_key(key_t generation, key_t index) { return ((generation << index_bits) | index) ^ xor_key; }
+
+    // The slot a key names, with the tag it holds while that handle is live. Null for keys that never named one.
+    static Slot* find(key_t key, key_t& tag) {
+        key_t raw = key ^ xor_key;
+        key_t generation = raw >> index_bits;
+        key_t index = raw & index_mask;
+        if (generation == 0 || generation > generation_mask) {
+            return nullptr;
+        }
+        Slot* chunk = table().chunks[static_cast<std::size_t>(index >> chunk_bits)].load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        tag = generation << 1 | 1;
+        return &chunk[index & (chunk_size - 1)];
+    }
+
+    // Frees the retired slots no hazard pointer names, moving their objects into released. Called under the mutex.
+    static void reclaim(Table& t, std::vector<std::shared_ptr<T>>& released) {
+        std::vector<Slot*> pinned;
+        for (HazardRecord* record = t.records.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            for (auto& hazard : record->hazards) {
+                Slot* slot = hazard.load(std::memory_order_seq_cst);
+                if (slot != nullptr) {
+                    pinned.push_back(slot);
+                }
+            }
+        }
+        std::size_t kept = 0;
+        for (Slot* slot : t.retired) {
+            bool is_pinned = false;
+            for (Slot* pin : pinned) {
+                is_pinned = is_pinned || pin == slot;
+            }
+            if (is_pinned) {
+                t.retired[kept++] = slot;
+            } else {
+                released.push_back(std::move(slot->owner));
+                t.free_slots.push_back(slot);
+            }
+        }
+        t.retired.resize(kept);
+    }
+
+    // A hazard pointer of the calling thread not in use, null when all are.
+    static std::atomic<Slot*>* free_hazard() {
+        HazardRecord& record = thread_record();
+        for (auto& hazard : record.hazards) {
+            if (hazard.load(std::memory_order_relaxed) == nullptr) {
+                return &hazard;
+            }
+        }
+        return nullptr;
+    }
+
+    // Records are never freed. A thread that exits hands its record to the next thread that needs one.
+    static HazardRecord& thread_record() {
+        struct Owner {
+            HazardRecord* record;
+            Owner() : record(acquire_record()) {}
+            ~Owner() { record->active.store(false, std::memory_order_release); }
+        };
+        static thread_local Owner owner;
+        return *owner.record;
+    }
+
+    static HazardRecord* acquire_record() {
+        Table& t = table();
+        for (HazardRecord* record = t.records.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            bool expected = false;
+            if (!record->active.load(std::memory_order_relaxed) &&
+                record->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        auto* record = new HazardRecord();
+        record->active.store(true, std::memory_order_relaxed);
+        HazardRecord* head = t.records.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!t.records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
     }
 
-    static std::shared_mutex& mutex() {
-        static std::shared_mutex mutex;
-        return mutex;
+    static Table& table() {
+        static Table table;
+        return table;
     }
 };
 }  // namespace zzt::qrcode
@@ -0,0 +1,68 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zzt::qrcode {
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    // Open through the wide path so that non-ASCII names work regardless of the ANSI code page.
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr) {
+                data_ = static_cast<const unsigned char *>(view);
+                size_ = static_cast<size_t>(file_size.QuadPart);
+            }
+            // The view keeps the mapping alive.
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            // The decoder reads the file front to back exactly once.
+            madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const unsigned char *>(view);
+            size_ = static_cast<size_t>(st.st_size);
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<unsigned char *>(data_), size_);
+    }
+}
+#endif
+}  // namespace zzt::qrcode
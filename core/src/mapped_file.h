@@ -0,0 +1,33 @@
+#ifndef ZZT_MAPPED_FILE_H
+#define ZZT_MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+namespace zzt::qrcode {
+/**
+ * Read-only memory mapping of a whole file.
+ * The file contents are paged in on demand instead of being read through buffered stdio.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @return false if the file could not be opened or mapped, or is empty.
+     */
+    [[nodiscard]] bool is_open() const { return data_ != nullptr; }
+    [[nodiscard]] const unsigned char *data() const { return data_; }
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    const unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+};
+}  // namespace zzt::qrcode
+
+#endif  // ZZT_MAPPED_FILE_H
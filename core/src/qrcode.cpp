@@ -1,28 +1,135 @@
 #include "zzt_qrcode/qrcode.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "handle.h"
-#include "mat.h"
+#include "mapped_file.h"
 #include "opencv2/wechat_qrcode.hpp"
 #include "qrcode_result.h"
 #include "simpleocv.h"
+#include "wechat_qrcode/src/gray_convert.hpp"
+#include "worker_pool.h"
 
-#ifdef __ANDROID__
-#include <android/log.h>
-#endif
+struct WeChatQRCode : cv::wechat_qrcode::WeChatQRCode, zzt::qrcode::Handle<WeChatQRCode, zzt_qrcode_detector_h> {
+    using cv::wechat_qrcode::WeChatQRCode::WeChatQRCode;
 
-struct WeChatQRCode : cv::wechat_qrcode::WeChatQRCode, zzt::qrcode::Handle<WeChatQRCode, zzt_qrcode_detector_h> {};
+    std::atomic<bool> stats_enabled{false};
+    std::mutex stats_mutex;
+    cv::wechat_qrcode::DecodeStats stats;  // aggregated over all calls since the last reset
+};
 struct QrcodeResultList : std::vector<std::shared_ptr<zzt::qrcode::QrcodeResult>>,
-                          zzt::qrcode::Handle<QrcodeResultList, zzt_qrcode_result_h> {};
+                          zzt::qrcode::Handle<QrcodeResultList, zzt_qrcode_result_h> {
+    cv::wechat_qrcode::DecodeStats stats;  // stats of the call that produced this list, zero when disabled
+};
+
+struct QrcodeStream : zzt::qrcode::Handle<QrcodeStream, zzt_qrcode_stream_h> {
+    QrcodeStream(std::shared_ptr<WeChatQRCode> detector, int refresh_interval) : detector(std::move(detector)) {
+        state.refresh_interval = refresh_interval;
+    }
+
+    std::shared_ptr<WeChatQRCode> detector;
+    std::mutex mutex;  // frames of a stream depend on each other and are decoded one at a time
+    cv::wechat_qrcode::StreamState state;
+};
+
+struct QrcodeCancelToken : zzt::qrcode::Handle<QrcodeCancelToken, zzt_qrcode_cancel_token_h> {
+    std::atomic<bool> cancelled{false};
+};
+
+struct QrcodeTicket : zzt::qrcode::Handle<QrcodeTicket, zzt_qrcode_ticket_h> {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;
+    zzt_qrcode_error_t error = ZZT_QRCODE_ERROR_PENDING;
+    zzt_qrcode_result_h result = nullptr;
+
+    ~QrcodeTicket() {
+        // Nobody collected the result before the ticket was released.
+        if (result != nullptr) {
+            QrcodeResultList::release_handle(result);
+        }
+    }
+
+    void complete(zzt_qrcode_error_t ret, zzt_qrcode_result_h ret_result) {
+        {
+            std::lock_guard g(mutex);
+            error = ret;
+            result = ret_result;
+            done = true;
+        }
+        cond.notify_all();
+    }
+};
 
 zzt_qrcode_detector_h zzt_qrcode_create_detector() { return WeChatQRCode::create_handle(); }
 
+void zzt_qrcode_init_options(zzt_qrcode_options_t *options) {
+    if (options == nullptr) {
+        return;
+    }
+    *options = zzt_qrcode_options_t{};
+    options->use_nn_detector = 1;
+    options->use_super_resolution = 1;
+    options->detector_target_area = 400.f * 400.f;
+    options->num_threads = 1;
+    options->decode_threads = 1;
+}
+
+zzt_qrcode_detector_h zzt_qrcode_create_detector_ex(const zzt_qrcode_options_t *options) {
+    if (options == nullptr) {
+        return zzt_qrcode_create_detector();
+    }
+    if (options->binarizer_count < 0 || options->binarizer_count > ZZT_QRCODE_BINARIZER_COUNT ||
+        options->scale_count < 0 || options->scale_count > ZZT_QRCODE_MAX_SCALES ||
+        !(options->detector_target_area > 0) || options->num_threads <= 0 || options->decode_threads < 0 ||
+        options->max_results < 0) {
+        return nullptr;
+    }
+
+    cv::wechat_qrcode::WeChatQRCode::Options engine_options;
+    engine_options.use_nn_detector = options->use_nn_detector != 0;
+    engine_options.use_nn_sr = options->use_super_resolution != 0;
+    for (int i = 0; i < options->binarizer_count; ++i) {
+        int binarizer = options->binarizers[i];
+        if (binarizer < 0 || binarizer >= ZZT_QRCODE_BINARIZER_COUNT) {
+            return nullptr;
+        }
+        engine_options.binarizers.push_back(binarizer);
+    }
+    for (int i = 0; i < options->scale_count; ++i) {
+        float scale = options->scales[i];
+        if (!(scale > 0)) {
+            return nullptr;
+        }
+        engine_options.scales.push_back(scale);
+    }
+    engine_options.detector_target_area = options->detector_target_area;
+    engine_options.num_threads = options->num_threads;
+    engine_options.speculative_scales = options->speculative_scales != 0;
+    engine_options.parallel_binarizers = options->parallel_binarizers != 0;
+    engine_options.adaptive_binarizers = options->adaptive_binarizers != 0;
+    engine_options.adaptive_scales = options->adaptive_scales != 0;
+    engine_options.max_results = options->max_results;
+    if (options->decode_threads != 1) {
+        int concurrency = options->decode_threads;
+        engine_options.parallel_for = [concurrency](int count, const std::function<void(int)> &body) {
+            zzt::qrcode::WorkerPool::instance().parallel_for(count, concurrency, body);
+        };
+    }
+    return WeChatQRCode::create_handle(engine_options);
+}
+
 zzt_qrcode_error_t zzt_qrcode_release_detector(zzt_qrcode_detector_h detector) {
     if (detector == nullptr) {
         return ZZT_QRCODE_ERROR_INVALID_HANDLE;
@@ -30,7 +137,66 @@ zzt_qrcode_error_t zzt_qrcode_release_detector(zzt_qrcode_detector_h detector) {
     return WeChatQRCode::release_handle(detector) ? ZZT_QRCODE_OK : ZZT_QRCODE_ERROR_INVALID_HANDLE;
 }
 
-static zzt_qrcode_error_t qrcode_detect_and_decode_internal(zzt_qrcode_detector_h detector, cv::Mat &img,
+// A grayscale image to decode: img, or when pixels is set, the caller's rows, which are only read and never copied.
+struct QrcodeGray {
+    cv::Mat img;
+    const unsigned char *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;
+};
+
+static zzt_qrcode_error_t qrcode_decode_image(WeChatQRCode &detector, const QrcodeGray &gray,
+                                              zzt_qrcode_result_h *out_result,
+                                              cv::wechat_qrcode::StreamState *stream_state = nullptr,
+                                              cv::wechat_qrcode::DecodeControl *control = nullptr,
+                                              cv::wechat_qrcode::DecodeScratch *scratch = nullptr) {
+    const bool borrowed = gray.pixels != nullptr;
+    if (!borrowed && gray.img.empty()) {
+        return ZZT_QRCODE_ERROR_DECODE_FAILED;
+    }
+    const unsigned char *pixels = borrowed ? gray.pixels : gray.img.data;
+    const int width = borrowed ? gray.width : gray.img.cols;
+    const int height = borrowed ? gray.height : gray.img.rows;
+    const size_t stride = borrowed ? gray.stride : static_cast<size_t>(gray.img.cols);
+
+    std::vector<cv::Mat> points;
+    std::vector<std::vector<uint8_t>> raw_bytes;
+    QrcodeResultList result_vector;
+    const bool stats_enabled = detector.stats_enabled.load(std::memory_order_relaxed);
+    auto *stats = stats_enabled ? &result_vector.stats : nullptr;
+    auto results = stream_state != nullptr
+                       ? detector.detectAndDecodeStream(pixels, width, height, stride, *stream_state, points,
+                                                        raw_bytes, stats, control)
+                       : detector.detectAndDecode(pixels, width, height, stride, points, raw_bytes, stats, control,
+                                                  scratch);
+    if (stats_enabled) {
+        std::lock_guard g(detector.stats_mutex);
+        detector.stats += result_vector.stats;
+    }
+    size_t result_len = results.size();
+    if (result_len > 0) {
+        result_vector.reserve(result_len);
+        for (int i = 0; i < result_len; ++i) {
+            result_vector.emplace_back(
+                std::make_shared<zzt::qrcode::QrcodeResult>(results[i], points[i], std::move(raw_bytes[i])));
+        }
+    }
+    *out_result = QrcodeResultList::create_handle(std::move(result_vector));
+    if (control) {
+        switch (control->status()) {
+            case cv::wechat_qrcode::DecodeControl::TIMED_OUT:
+                return ZZT_QRCODE_ERROR_TIMEOUT;
+            case cv::wechat_qrcode::DecodeControl::CANCELLED:
+                return ZZT_QRCODE_ERROR_CANCELLED;
+            default:
+                break;
+        }
+    }
+    return ZZT_QRCODE_OK;
+}
+
+static zzt_qrcode_error_t qrcode_detect_and_decode_internal(zzt_qrcode_detector_h detector, const QrcodeGray &gray,
                                                           zzt_qrcode_result_h *out_result) {
     if (out_result == nullptr) {
         return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
@@ -42,29 +208,131 @@ static zzt_qrcode_error_t qrcode_detect_and_decode_internal(zzt_qrcode_detector_
         return ZZT_QRCODE_ERROR_INVALID_HANDLE;
     }
 
-    if (img.empty()) {
-        return ZZT_QRCODE_ERROR_DECODE_FAILED;
+    return qrcode_decode_image(*detector_ptr, gray, out_result);
+}
+
+// Decode encoded image data into a grayscale image through simpleocv's imdecode. It only accepts a std::vector, so
+// the data is copied once into a vector that lives for this call only, and no thread keeps a buffer as large as the
+// biggest image it has seen. A failed decode leaves img empty.
+static void qrcode_decode_bytes(const unsigned char *data, size_t data_len, cv::Mat &img) {
+    std::vector<uchar> bytes(data, data + data_len);
+    img = cv::imdecode(bytes, cv::IMREAD_GRAYSCALE);
+}
+
+static zzt_qrcode_error_t qrcode_load_data(const unsigned char *data, int data_len, cv::Mat &img) {
+    if (data == nullptr || data_len <= 0) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
     }
+    qrcode_decode_bytes(data, static_cast<size_t>(data_len), img);
+    return ZZT_QRCODE_OK;
+}
 
-    std::vector<cv::Mat> points;
-    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-    auto results = detector_ptr->detectAndDecode(img, points);
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end - start;
-#ifdef __ANDROID__
-    __android_log_print(ANDROID_LOG_WARN, "zzt_jni", "detectAndDecode %f seconds", elapsed_seconds.count());
+// Map the file and decode from the mapping, so the only copy of the file is the one imdecode needs. A missing or
+// unreadable file leaves img empty, which is reported as ZZT_QRCODE_ERROR_DECODE_FAILED like an undecodable image.
+static zzt_qrcode_error_t qrcode_load_path(const std::filesystem::path &fs_path, cv::Mat &img) {
+    zzt::qrcode::MappedFile file(fs_path);
+    if (!file.is_open()) {
+        img = cv::Mat();
+        return ZZT_QRCODE_OK;
+    }
+    qrcode_decode_bytes(file.data(), file.size(), img);
+    return ZZT_QRCODE_OK;
+}
+
+static std::filesystem::path qrcode_make_path(const char8_t *path) {
+#ifdef __cpp_lib_char8_t
+    return std::filesystem::path(path);
 #else
-    std::cout << "detectAndDecode " << elapsed_seconds.count() << " seconds" << std::endl;
+    return std::filesystem::u8path(reinterpret_cast<const char*>(path));
 #endif
-    size_t result_len = results.size();
-    QrcodeResultList result_vector;
-    if (result_len > 0) {
-        result_vector.reserve(result_len);
-        for (int i = 0; i < result_len; ++i) {
-            result_vector.emplace_back(std::make_shared<zzt::qrcode::QrcodeResult>(results[i], points[i]));
-        }
+}
+
+// Make img a single-channel buffer of the given size. The buffer is reused when it already has that size, so callers
+// decoding many frames of the same size allocate it only once.
+static void qrcode_prepare_gray(cv::Mat &img, int width, int height) {
+    if (img.empty() || img.rows != height || img.cols != width || img.channels() != 1) {
+        img.create(height, width, CV_8UC1);
+    }
+}
+
+// Load grayscale pixels. When borrow is set gray reads the caller's rows in place, padded or not, and no pixel data
+// is touched; otherwise the rows are copied into gray.img.
+static void qrcode_load_gray(const unsigned char *pixels, int width, int height, int stride, bool borrow,
+                             QrcodeGray &gray) {
+    if (stride <= 0) {
+        stride = width;
+    }
+    if (borrow) {
+        gray.pixels = pixels;
+        gray.width = width;
+        gray.height = height;
+        gray.stride = static_cast<size_t>(stride);
+        return;
     }
-    *out_result = QrcodeResultList::create_handle(result_vector);
+    gray.pixels = nullptr;
+    cv::Mat &img = gray.img;
+    qrcode_prepare_gray(img, width, height);
+    if (stride == width) {
+        memcpy(img.data, pixels, (size_t)width * height);
+        return;
+    }
+    for (int y = 0; y < height; ++y) {
+        memcpy(img.data + (size_t)y * width, pixels + (size_t)y * stride, width);
+    }
+}
+
+// Convert raw pixel data into a grayscale image. Gray input and the luma plane of YUV input are borrowed or copied directly (see qrcode_load_gray);
+// color input is converted straight to 8-bit gray into gray.img, reusing it as the output buffer when possible. Borrowed
+// pixels are only valid while the caller's pixel buffer is, so asynchronous callers must pass borrow = false.
+static zzt_qrcode_error_t qrcode_load_pixels(const unsigned char *pixels, zzt_qrcode_pixel_format_t format,
+                                             int width, int height, int stride, bool borrow, QrcodeGray &gray) {
+    if (pixels == nullptr || width <= 0 || height <= 0) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    cv::wechat_qrcode::GrayPixelLayout layout;
+    switch (format) {
+        case ZZT_QRCODE_PIXEL_GRAY:
+        case ZZT_QRCODE_PIXEL_NV21:
+        case ZZT_QRCODE_PIXEL_NV12:
+        case ZZT_QRCODE_PIXEL_I420:
+        case ZZT_QRCODE_PIXEL_YV12:
+            // The Y plane of the YUV formats is already the grayscale image.
+            if (stride > 0 && stride < width) {
+                return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+            }
+            qrcode_load_gray(pixels, width, height, stride, borrow, gray);
+            return ZZT_QRCODE_OK;
+        case ZZT_QRCODE_PIXEL_RGB:
+            layout = cv::wechat_qrcode::GRAY_FROM_RGB;
+            break;
+        case ZZT_QRCODE_PIXEL_BGR:
+            layout = cv::wechat_qrcode::GRAY_FROM_BGR;
+            break;
+        case ZZT_QRCODE_PIXEL_RGBA:
+            layout = cv::wechat_qrcode::GRAY_FROM_RGBA;
+            break;
+        case ZZT_QRCODE_PIXEL_BGRA:
+            layout = cv::wechat_qrcode::GRAY_FROM_BGRA;
+            break;
+        case ZZT_QRCODE_PIXEL_ARGB:
+            layout = cv::wechat_qrcode::GRAY_FROM_ARGB;
+            break;
+        case ZZT_QRCODE_PIXEL_ABGR:
+            layout = cv::wechat_qrcode::GRAY_FROM_ABGR;
+            break;
+        default:
+            return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t row_bytes = (size_t)width * cv::wechat_qrcode::grayPixelSize(layout);
+    if (stride > 0 && (size_t)stride < row_bytes) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    gray.pixels = nullptr;
+    qrcode_prepare_gray(gray.img, width, height);
+    cv::wechat_qrcode::convertToGray(pixels, layout, width, height, stride > 0 ? (size_t)stride : row_bytes,
+                                     gray.img.data, width);
     return ZZT_QRCODE_OK;
 }
 
@@ -76,12 +344,12 @@ zzt_qrcode_detect_and_decode_data(zzt_qrcode_detector_h detector, const unsigned
     }
     *out_result = nullptr;
 
-    if (data == nullptr || data_len <= 0) {
-        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    QrcodeGray gray;
+    zzt_qrcode_error_t ret = qrcode_load_data(data, data_len, gray.img);
+    if (ret != ZZT_QRCODE_OK) {
+        return ret;
     }
-    std::vector bytes_vector(data, data + data_len);
-    cv::Mat img = cv::imdecode(bytes_vector, cv::IMREAD_GRAYSCALE);
-    return qrcode_detect_and_decode_internal(detector, img, out_result);
+    return qrcode_detect_and_decode_internal(detector, gray, out_result);
 }
 
 zzt_qrcode_error_t
@@ -96,13 +364,9 @@ zzt_qrcode_detect_and_decode_path_u8(zzt_qrcode_detector_h detector, const char8
         return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
     }
 
-#ifdef __cpp_lib_char8_t
-    std::filesystem::path fs_path(path);
-#else
-    std::filesystem::path fs_path = std::filesystem::u8path(reinterpret_cast<const char*>(path));
-#endif
-    cv::Mat img = cv::imread(fs_path.string(), cv::IMREAD_GRAYSCALE);
-    return qrcode_detect_and_decode_internal(detector, img, out_result);
+    QrcodeGray gray;
+    qrcode_load_path(qrcode_make_path(path), gray.img);
+    return qrcode_detect_and_decode_internal(detector, gray, out_result);
 }
 
 zzt_qrcode_error_t
@@ -117,9 +381,9 @@ zzt_qrcode_detect_and_decode_path_u16(zzt_qrcode_detector_h detector, const char
         return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
     }
 
-    std::filesystem::path fs_path(path);
-    cv::Mat img = cv::imread(fs_path.string(), cv::IMREAD_GRAYSCALE);
-    return qrcode_detect_and_decode_internal(detector, img, out_result);
+    QrcodeGray gray;
+    qrcode_load_path(std::filesystem::path(path), gray.img);
+    return qrcode_detect_and_decode_internal(detector, gray, out_result);
 }
 
 zzt_qrcode_error_t
@@ -131,52 +395,314 @@ zzt_qrcode_detect_and_decode_pixels(zzt_qrcode_detector_h detector, const unsign
     }
     *out_result = nullptr;
 
-    if (pixels == nullptr || width <= 0 || height <= 0) {
-        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    QrcodeGray gray;
+    zzt_qrcode_error_t ret = qrcode_load_pixels(pixels, format, width, height, stride, true, gray);
+    if (ret != ZZT_QRCODE_OK) {
+        return ret;
     }
+    return qrcode_detect_and_decode_internal(detector, gray, out_result);
+}
 
-    ncnn::Mat::PixelType pixel_type;
-    const unsigned char *actual_pixels = pixels;
-    switch (format) {
-        case ZZT_QRCODE_PIXEL_GRAY:
-            pixel_type = ncnn::Mat::PIXEL_GRAY;
-            break;
-        case ZZT_QRCODE_PIXEL_RGB:
-            pixel_type = ncnn::Mat::PIXEL_RGB2GRAY;
-            break;
-        case ZZT_QRCODE_PIXEL_BGR:
-            pixel_type = ncnn::Mat::PIXEL_BGR2GRAY;
-            break;
-        case ZZT_QRCODE_PIXEL_RGBA:
-            pixel_type = ncnn::Mat::PIXEL_RGBA2GRAY;
-            break;
-        case ZZT_QRCODE_PIXEL_BGRA:
-            pixel_type = ncnn::Mat::PIXEL_BGRA2GRAY;
-            break;
-        case ZZT_QRCODE_PIXEL_ARGB:
-            pixel_type = ncnn::Mat::PIXEL_RGBA2GRAY;
-            actual_pixels = pixels + 1;
-            break;
-        case ZZT_QRCODE_PIXEL_ABGR:
-            pixel_type = ncnn::Mat::PIXEL_BGRA2GRAY;
-            actual_pixels = pixels + 1;
-            break;
+static zzt_qrcode_error_t qrcode_load_image(const zzt_qrcode_image_t &image, QrcodeGray &gray) {
+    switch (image.type) {
+        case ZZT_QRCODE_IMAGE_DATA:
+            gray.pixels = nullptr;
+            return qrcode_load_data(image.data, image.data_len, gray.img);
+        case ZZT_QRCODE_IMAGE_PIXELS:
+            return qrcode_load_pixels(image.data, image.format, image.width, image.height, image.stride, true, gray);
         default:
             return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
     }
+}
 
-    ncnn::Mat ncnn_img;
-    if (stride > 0) {
-        ncnn_img = ncnn::Mat::from_pixels(actual_pixels, pixel_type, width, height, stride);
-    } else {
-        ncnn_img = ncnn::Mat::from_pixels(actual_pixels, pixel_type, width, height);
+zzt_qrcode_error_t
+zzt_qrcode_detect_and_decode_batch(zzt_qrcode_detector_h detector, const zzt_qrcode_image_t *images,
+                                   int image_count, zzt_qrcode_result_h *out_results,
+                                   zzt_qrcode_error_t *out_errors) {
+    if (out_results == nullptr || images == nullptr || image_count <= 0) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    std::fill(out_results, out_results + image_count, nullptr);
+    if (out_errors) {
+        std::fill(out_errors, out_errors + image_count, ZZT_QRCODE_ERROR_INVALID_HANDLE);
     }
 
-    cv::Mat img;
-    img.create(height, width, CV_8UC1);
-    ncnn_img.to_pixels(img.data, ncnn::Mat::PIXEL_GRAY);
+    // Look the detector up once and keep it alive for the whole batch.
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+
+    // Buffers kept for the whole batch. Color pixels are converted into gray.img while the sizes match, gray pixels
+    // are read in place and leave it alone, and encoded data is decoded into a new image that then takes its place.
+    // The detector reuses its input and network buffers through scratch.
+    QrcodeGray gray;
+    cv::wechat_qrcode::DecodeScratch scratch;
+    for (int i = 0; i < image_count; ++i) {
+        zzt_qrcode_error_t ret = qrcode_load_image(images[i], gray);
+        if (ret == ZZT_QRCODE_OK) {
+            ret = qrcode_decode_image(*detector_ptr, gray, &out_results[i], nullptr, nullptr, &scratch);
+        }
+        if (out_errors) {
+            out_errors[i] = ret;
+        }
+    }
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t
+zzt_qrcode_detect_and_decode_image(zzt_qrcode_detector_h detector, const zzt_qrcode_image_t *image,
+                                   const zzt_qrcode_call_options_t *call_options, zzt_qrcode_result_h *out_result) {
+    if (out_result == nullptr || image == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    *out_result = nullptr;
+
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    // Keep the token alive for the whole call, it may be released by another thread meanwhile.
+    std::shared_ptr<QrcodeCancelToken> token_ptr;
+    if (call_options && call_options->cancel_token) {
+        token_ptr = QrcodeCancelToken::get(call_options->cancel_token);
+        if (token_ptr == nullptr) {
+            return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+        }
+    }
+
+    QrcodeGray gray;
+    zzt_qrcode_error_t ret = qrcode_load_image(*image, gray);
+    if (ret != ZZT_QRCODE_OK) {
+        return ret;
+    }
+    if (call_options == nullptr) {
+        return qrcode_decode_image(*detector_ptr, gray, out_result);
+    }
+    cv::wechat_qrcode::DecodeControl control(call_options->timeout_ms,
+                                             token_ptr ? &token_ptr->cancelled : nullptr);
+    return qrcode_decode_image(*detector_ptr, gray, out_result, nullptr, &control);
+}
+
+zzt_qrcode_cancel_token_h zzt_qrcode_create_cancel_token() { return QrcodeCancelToken::create_handle(); }
+
+zzt_qrcode_error_t zzt_qrcode_cancel(zzt_qrcode_cancel_token_h token) {
+    auto token_ptr = QrcodeCancelToken::borrow(token);
+    if (!token_ptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    token_ptr->cancelled.store(true, std::memory_order_relaxed);
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_release_cancel_token(zzt_qrcode_cancel_token_h token) {
+    if (token == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    return QrcodeCancelToken::release_handle(token) ? ZZT_QRCODE_OK : ZZT_QRCODE_ERROR_INVALID_HANDLE;
+}
+
+zzt_qrcode_stream_h zzt_qrcode_create_stream(zzt_qrcode_detector_h detector, int refresh_interval) {
+    if (refresh_interval < 0) {
+        return nullptr;
+    }
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return nullptr;
+    }
+    return QrcodeStream::create_handle(std::move(detector_ptr), refresh_interval);
+}
+
+zzt_qrcode_error_t zzt_qrcode_release_stream(zzt_qrcode_stream_h stream) {
+    if (stream == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    return QrcodeStream::release_handle(stream) ? ZZT_QRCODE_OK : ZZT_QRCODE_ERROR_INVALID_HANDLE;
+}
+
+zzt_qrcode_error_t zzt_qrcode_reset_stream(zzt_qrcode_stream_h stream) {
+    auto stream_ptr = QrcodeStream::get(stream);
+    if (stream_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    std::lock_guard g(stream_ptr->mutex);
+    stream_ptr->state.tracked_points.clear();
+    stream_ptr->state.frames_since_refresh = 0;
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t
+zzt_qrcode_stream_decode_pixels(zzt_qrcode_stream_h stream, const unsigned char *pixels,
+                                zzt_qrcode_pixel_format_t format, int width, int height, int stride,
+                                zzt_qrcode_result_h *out_result) {
+    if (out_result == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    *out_result = nullptr;
+
+    auto stream_ptr = QrcodeStream::get(stream);
+    if (stream_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+
+    QrcodeGray gray;
+    zzt_qrcode_error_t ret = qrcode_load_pixels(pixels, format, width, height, stride, true, gray);
+    if (ret != ZZT_QRCODE_OK) {
+        return ret;
+    }
+    std::lock_guard g(stream_ptr->mutex);
+    return qrcode_decode_image(*stream_ptr->detector, gray, out_result, &stream_ptr->state);
+}
+
+zzt_qrcode_error_t zzt_qrcode_set_worker_threads(int thread_count) {
+    if (thread_count < 0) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    return zzt::qrcode::WorkerPool::instance().set_thread_count(thread_count) ? ZZT_QRCODE_OK
+                                                                              : ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+}
+
+// Queue a decode on the worker pool. The loader runs on the worker thread and produces the grayscale image.
+static zzt_qrcode_error_t qrcode_submit(zzt_qrcode_detector_h detector, std::function<zzt_qrcode_error_t(cv::Mat &)> load,
+                                        zzt_qrcode_callback_t callback, void *user_data,
+                                        zzt_qrcode_ticket_h *out_ticket) {
+    // Keep the detector alive until the task has run, even if the handle is released meanwhile.
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+
+    std::shared_ptr<QrcodeTicket> ticket;
+    if (out_ticket != nullptr) {
+        *out_ticket = QrcodeTicket::create_handle();
+        ticket = QrcodeTicket::get(*out_ticket);
+    }
+
+    auto finish = [callback, user_data, ticket](zzt_qrcode_error_t ret, zzt_qrcode_result_h result) {
+        if (callback != nullptr) {
+            callback(ret, result, user_data);
+            result = nullptr;
+        }
+        if (ticket != nullptr) {
+            ticket->complete(ret, result);
+        }
+    };
+    zzt::qrcode::WorkerPool::instance().submit(
+        [detector_ptr, load = std::move(load), finish]() {
+            QrcodeGray gray;
+            zzt_qrcode_result_h result = nullptr;
+            zzt_qrcode_error_t ret = load(gray.img);
+            if (ret == ZZT_QRCODE_OK) {
+                ret = qrcode_decode_image(*detector_ptr, gray, &result);
+            }
+            finish(ret, result);
+        },
+        // still queued when the library unloads
+        [finish]() { finish(ZZT_QRCODE_ERROR_CANCELLED, nullptr); });
+    return ZZT_QRCODE_OK;
+}
+
+static bool qrcode_check_submit_args(zzt_qrcode_callback_t callback, zzt_qrcode_ticket_h *out_ticket) {
+    if (out_ticket != nullptr) {
+        *out_ticket = nullptr;
+    }
+    // Without a callback or a ticket the result could never be collected.
+    return callback != nullptr || out_ticket != nullptr;
+}
+
+zzt_qrcode_error_t
+zzt_qrcode_submit_data(zzt_qrcode_detector_h detector, const unsigned char *data, int data_len,
+                       zzt_qrcode_callback_t callback, void *user_data, zzt_qrcode_ticket_h *out_ticket) {
+    if (!qrcode_check_submit_args(callback, out_ticket) || data == nullptr || data_len <= 0) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    auto bytes = std::make_shared<std::vector<uchar>>(data, data + data_len);
+    return qrcode_submit(
+        detector,
+        [bytes](cv::Mat &img) {
+            img = cv::imdecode(*bytes, cv::IMREAD_GRAYSCALE);
+            return ZZT_QRCODE_OK;
+        },
+        callback, user_data, out_ticket);
+}
+
+zzt_qrcode_error_t
+zzt_qrcode_submit_path_u8(zzt_qrcode_detector_h detector, const char8_t *path, zzt_qrcode_callback_t callback,
+                          void *user_data, zzt_qrcode_ticket_h *out_ticket) {
+    if (!qrcode_check_submit_args(callback, out_ticket) || path == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::filesystem::path fs_path = qrcode_make_path(path);
+    return qrcode_submit(
+        detector, [fs_path](cv::Mat &img) { return qrcode_load_path(fs_path, img); }, callback, user_data,
+        out_ticket);
+}
 
-    return qrcode_detect_and_decode_internal(detector, img, out_result);
+zzt_qrcode_error_t
+zzt_qrcode_submit_path_u16(zzt_qrcode_detector_h detector, const char16_t *path, zzt_qrcode_callback_t callback,
+                           void *user_data, zzt_qrcode_ticket_h *out_ticket) {
+    if (!qrcode_check_submit_args(callback, out_ticket) || path == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::filesystem::path fs_path(path);
+    return qrcode_submit(
+        detector, [fs_path](cv::Mat &img) { return qrcode_load_path(fs_path, img); }, callback, user_data,
+        out_ticket);
+}
+
+zzt_qrcode_error_t
+zzt_qrcode_submit_pixels(zzt_qrcode_detector_h detector, const unsigned char *pixels,
+                         zzt_qrcode_pixel_format_t format, int width, int height, int stride,
+                         zzt_qrcode_callback_t callback, void *user_data, zzt_qrcode_ticket_h *out_ticket) {
+    if (!qrcode_check_submit_args(callback, out_ticket)) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Convert on the calling thread so the caller may reuse its pixel buffer as soon as this returns.
+    QrcodeGray gray;
+    zzt_qrcode_error_t ret = qrcode_load_pixels(pixels, format, width, height, stride, false, gray);
+    if (ret != ZZT_QRCODE_OK) {
+        return ret;
+    }
+    return qrcode_submit(
+        detector,
+        [gray = gray.img](cv::Mat &img) {
+            img = gray;
+            return ZZT_QRCODE_OK;
+        },
+        callback, user_data, out_ticket);
+}
+
+zzt_qrcode_error_t zzt_qrcode_wait_ticket(zzt_qrcode_ticket_h ticket, int timeout_ms, zzt_qrcode_result_h *out_result) {
+    if (out_result != nullptr) {
+        *out_result = nullptr;
+    }
+    auto ticket_ptr = QrcodeTicket::get(ticket);
+    if (ticket_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+
+    std::unique_lock g(ticket_ptr->mutex);
+    if (timeout_ms < 0) {
+        ticket_ptr->cond.wait(g, [&] { return ticket_ptr->done; });
+    } else if (!ticket_ptr->cond.wait_for(g, std::chrono::milliseconds(timeout_ms), [&] { return ticket_ptr->done; })) {
+        return ZZT_QRCODE_ERROR_PENDING;
+    }
+    if (out_result != nullptr) {
+        *out_result = ticket_ptr->result;
+        ticket_ptr->result = nullptr;
+    }
+    return ticket_ptr->error;
+}
+
+zzt_qrcode_error_t zzt_qrcode_release_ticket(zzt_qrcode_ticket_h ticket) {
+    if (ticket == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    return QrcodeTicket::release_handle(ticket) ? ZZT_QRCODE_OK : ZZT_QRCODE_ERROR_INVALID_HANDLE;
 }
 
 zzt_qrcode_error_t zzt_qrcode_release_result(zzt_qrcode_result_h result) {
@@ -188,8 +714,8 @@ zzt_qrcode_error_t zzt_qrcode_release_result(zzt_qrcode_result_h result) {
 
 zzt_qrcode_error_t
 zzt_qrcode_get_result_size(zzt_qrcode_result_h result, int *size) {
-    auto result_ptr = QrcodeResultList::get(result);
-    if (result_ptr == nullptr) {
+    auto result_ptr = QrcodeResultList::borrow(result);
+    if (!result_ptr) {
         if (size) {
             *size = 0;
         }
@@ -203,8 +729,8 @@ zzt_qrcode_get_result_size(zzt_qrcode_result_h result, int *size) {
 
 zzt_qrcode_error_t
 zzt_qrcode_get_result_text(zzt_qrcode_result_h result, int index, char *output_text, int *buffer_size) {
-    auto result_ptr = QrcodeResultList::get(result);
-    if (result_ptr == nullptr) {
+    auto result_ptr = QrcodeResultList::borrow(result);
+    if (!result_ptr) {
         if (buffer_size) {
             *buffer_size = 0;
         }
@@ -237,8 +763,8 @@ zzt_qrcode_get_result_text(zzt_qrcode_result_h result, int index, char *output_t
 
 zzt_qrcode_error_t
 zzt_qrcode_get_result_points(zzt_qrcode_result_h result, int index, float *output_point, int *buffer_size) {
-    auto result_ptr = QrcodeResultList::get(result);
-    if (result_ptr == nullptr) {
+    auto result_ptr = QrcodeResultList::borrow(result);
+    if (!result_ptr) {
         return ZZT_QRCODE_ERROR_INVALID_HANDLE;
     }
     if (index < 0 || index >= (int)result_ptr->size()) {
@@ -264,3 +790,190 @@ zzt_qrcode_get_result_points(zzt_qrcode_result_h result, int index, float *outpu
     }
     return ZZT_QRCODE_OK;
 }
+
+zzt_qrcode_error_t
+zzt_qrcode_export_results(zzt_qrcode_result_h result, void *buffer, int *buffer_size) {
+    if (buffer_size == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    auto result_ptr = QrcodeResultList::borrow(result);
+    if (!result_ptr) {
+        *buffer_size = 0;
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+
+    // Layout: header, entry table, then all points, raw bytes and texts. The header and the table only hold ints,
+    // so the points that follow stay 4-byte aligned.
+    const int count = static_cast<int>(result_ptr->size());
+    size_t points_size = 0;
+    size_t raw_bytes_size = 0;
+    size_t text_size = 0;
+    for (const auto &item : *result_ptr) {
+        points_size += item->get_result_points().rows * 2 * sizeof(float);
+        raw_bytes_size += item->get_raw_bytes().size();
+        text_size += item->get_text().size() + 1;
+    }
+    const size_t table_size = sizeof(zzt_qrcode_export_header_t) + count * sizeof(zzt_qrcode_export_entry_t);
+    const size_t total_size = table_size + points_size + raw_bytes_size + text_size;
+    if (total_size > static_cast<size_t>(INT_MAX)) {
+        *buffer_size = 0;
+        return ZZT_QRCODE_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (buffer == nullptr) {
+        *buffer_size = static_cast<int>(total_size);
+        return ZZT_QRCODE_OK;
+    }
+    if (*buffer_size < static_cast<int>(total_size)) {
+        *buffer_size = static_cast<int>(total_size);
+        return ZZT_QRCODE_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    auto *base = static_cast<unsigned char *>(buffer);
+    auto *header = reinterpret_cast<zzt_qrcode_export_header_t *>(base);
+    auto *entries = reinterpret_cast<zzt_qrcode_export_entry_t *>(base + sizeof(zzt_qrcode_export_header_t));
+    header->size = static_cast<int>(total_size);
+    header->count = count;
+
+    size_t points_offset = table_size;
+    size_t raw_bytes_offset = points_offset + points_size;
+    size_t text_offset = raw_bytes_offset + raw_bytes_size;
+    for (int i = 0; i < count; ++i) {
+        const auto &item = result_ptr->at(i);
+        zzt_qrcode_export_entry_t &entry = entries[i];
+
+        const cv::Mat &result_points = item->get_result_points();
+        auto *points = reinterpret_cast<float *>(base + points_offset);
+        for (int j = 0; j < result_points.rows; ++j) {
+            points[j * 2] = result_points.ptr<float>(j)[0];
+            points[j * 2 + 1] = result_points.ptr<float>(j)[1];
+        }
+        entry.points_offset = static_cast<int>(points_offset);
+        entry.points_count = result_points.rows * 2;
+        points_offset += entry.points_count * sizeof(float);
+
+        const std::vector<uint8_t> &raw_bytes = item->get_raw_bytes();
+        std::copy(raw_bytes.begin(), raw_bytes.end(), base + raw_bytes_offset);
+        entry.raw_bytes_offset = static_cast<int>(raw_bytes_offset);
+        entry.raw_bytes_size = static_cast<int>(raw_bytes.size());
+        raw_bytes_offset += raw_bytes.size();
+
+        const std::string &text = item->get_text();
+        text.copy(reinterpret_cast<char *>(base + text_offset), text.size());
+        base[text_offset + text.size()] = '\0';
+        entry.text_offset = static_cast<int>(text_offset);
+        entry.text_size = static_cast<int>(text.size());
+        text_offset += text.size() + 1;
+    }
+    *buffer_size = static_cast<int>(total_size);
+    return ZZT_QRCODE_OK;
+}
+
+static void qrcode_copy_stats(const cv::wechat_qrcode::DecodeStats &stats, zzt_qrcode_stats_t *out_stats) {
+    out_stats->calls = stats.calls;
+    out_stats->successful_calls = stats.successful_calls;
+    out_stats->codes = stats.codes;
+    out_stats->candidates = stats.candidates;
+    out_stats->scale_attempts = stats.scale_attempts;
+    out_stats->tracked_calls = stats.tracked_calls;
+    for (int i = 0; i < ZZT_QRCODE_BINARIZER_COUNT; ++i) {
+        out_stats->binarizer_attempts[i] = stats.binarizer_attempts[i];
+        out_stats->binarizer_successes[i] = stats.binarizer_successes[i];
+        out_stats->binarizer_ms[i] = stats.binarizer_ms[i];
+    }
+    out_stats->total_ms = stats.total_ms;
+    out_stats->detect_ms = stats.detect_ms;
+    out_stats->crop_scale_ms = stats.crop_scale_ms;
+    out_stats->sr_ms = stats.sr_ms;
+    out_stats->finder_ms = stats.finder_ms;
+    out_stats->decoder_ms = stats.decoder_ms;
+}
+
+zzt_qrcode_error_t zzt_qrcode_set_stats_enabled(zzt_qrcode_detector_h detector, int enabled) {
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    detector_ptr->stats_enabled.store(enabled != 0, std::memory_order_relaxed);
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_get_result_stats(zzt_qrcode_result_h result, zzt_qrcode_stats_t *out_stats) {
+    if (out_stats == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    auto result_ptr = QrcodeResultList::borrow(result);
+    if (!result_ptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    qrcode_copy_stats(result_ptr->stats, out_stats);
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_get_detector_stats(zzt_qrcode_detector_h detector, zzt_qrcode_stats_t *out_stats) {
+    if (out_stats == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    std::lock_guard g(detector_ptr->stats_mutex);
+    qrcode_copy_stats(detector_ptr->stats, out_stats);
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_reset_detector_stats(zzt_qrcode_detector_h detector) {
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    std::lock_guard g(detector_ptr->stats_mutex);
+    detector_ptr->stats = cv::wechat_qrcode::DecodeStats();
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_save_binarizer_stats(zzt_qrcode_detector_h detector, char *output_text,
+                                                   int *buffer_size) {
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        if (buffer_size) {
+            *buffer_size = 0;
+        }
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    std::string text = detector_ptr->saveBinarizerStats();
+    if (text.empty()) {
+        if (buffer_size) {
+            *buffer_size = 0;
+        }
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    size_t text_size = text.size();
+    if (output_text != nullptr) {
+        int provided_size = buffer_size ? *buffer_size : 0;
+        if (provided_size <= static_cast<int>(text_size)) {
+            if (buffer_size) {
+                *buffer_size = static_cast<int>(text_size) + 1;
+            }
+            return ZZT_QRCODE_ERROR_BUFFER_TOO_SMALL;
+        }
+        text.copy(output_text, text_size);
+        output_text[text_size] = '\0';
+    }
+    if (buffer_size) {
+        *buffer_size = static_cast<int>(text_size) + 1;
+    }
+    return ZZT_QRCODE_OK;
+}
+
+zzt_qrcode_error_t zzt_qrcode_load_binarizer_stats(zzt_qrcode_detector_h detector, const char *text) {
+    auto detector_ptr = WeChatQRCode::get(detector);
+    if (detector_ptr == nullptr) {
+        return ZZT_QRCODE_ERROR_INVALID_HANDLE;
+    }
+    if (text == nullptr || !detector_ptr->loadBinarizerStats(text)) {
+        return ZZT_QRCODE_ERROR_INVALID_ARGUMENT;
+    }
+    return ZZT_QRCODE_OK;
+}
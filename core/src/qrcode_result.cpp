@@ -4,12 +4,14 @@
 #include <utility>
 
 namespace zzt::qrcode {
-QrcodeResult::QrcodeResult(std::string text, const cv::Mat &result_points)
-    : text(std::move(text)), result_points(result_points) {}
+QrcodeResult::QrcodeResult(std::string text, const cv::Mat &result_points, std::vector<uint8_t> raw_bytes)
+    : text(std::move(text)), result_points(result_points), raw_bytes(std::move(raw_bytes)) {}
 
 QrcodeResult::~QrcodeResult() = default;
 
 const std::string &QrcodeResult::get_text() const { return text; }
 
 const cv::Mat &QrcodeResult::get_result_points() const { return result_points; }
+
+const std::vector<uint8_t> &QrcodeResult::get_raw_bytes() const { return raw_bytes; }
 }  // namespace zzt::qrcode
@@ -1,14 +1,16 @@
 #ifndef ZZT_QRCODE_RESULT_H
 #define ZZT_QRCODE_RESULT_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "simpleocv.h"
 
 namespace zzt::qrcode {
 class QrcodeResult {
 public:
-    QrcodeResult(std::string text, const cv::Mat &result_points);
+    QrcodeResult(std::string text, const cv::Mat &result_points, std::vector<uint8_t> raw_bytes = {});
     ~QrcodeResult();
 
     QrcodeResult(const QrcodeResult &) = delete;
@@ -18,10 +20,12 @@ public:
 
     [[nodiscard]] const std::string &get_text() const;
     [[nodiscard]] const cv::Mat &get_result_points() const;
+    [[nodiscard]] const std::vector<uint8_t> &get_raw_bytes() const;
 
 private:
     std::string text;
     cv::Mat result_points;
+    std::vector<uint8_t> raw_bytes;
 };
 }  // namespace zzt::qrcode
 
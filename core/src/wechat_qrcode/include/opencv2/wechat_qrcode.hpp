@@ -7,6 +7,10 @@
 
 #ifndef __OPENCV_WECHAT_QRCODE_HPP__
 #define __OPENCV_WECHAT_QRCODE_HPP__
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include "simpleocv.h"
 
 /** @defgroup wechat_qrcode WeChat QR code detector for detecting and parsing QR code.
@@ -15,6 +19,107 @@ namespace cv {
 namespace wechat_qrcode {
 //! @addtogroup wechat_qrcode
 //! @{
+/**
+ * @brief Per-stage timings and counters of detectAndDecode calls.
+ * Times are in milliseconds. Every field is additive, so the stats of many calls can be
+ * aggregated with operator+=.
+ */
+struct DecodeStats {
+    enum { BINARIZER_COUNT = 4 };
+
+    int calls = 0;             //!< detectAndDecode calls
+    int successful_calls = 0;  //!< calls that decoded at least one QR code
+    int codes = 0;             //!< decoded QR codes
+    int candidates = 0;        //!< candidate regions reported by the detector
+    int scale_attempts = 0;    //!< decode attempts over all candidates and scales
+    int tracked_calls = 0;     //!< stream calls served from the previous frame's codes without detection
+    int binarizer_attempts[BINARIZER_COUNT] = {};   //!< attempts per binarizer (BinarizerMgr order)
+    int binarizer_successes[BINARIZER_COUNT] = {};  //!< successful attempts per binarizer
+    double binarizer_ms[BINARIZER_COUNT] = {};      //!< time per binarizer, including finder and decoder
+    double total_ms = 0;       //!< whole call
+    double detect_ms = 0;      //!< SSD detector inference
+    double crop_scale_ms = 0;  //!< candidate cropping and plain rescaling
+    double sr_ms = 0;          //!< super resolution upscaling
+    double finder_ms = 0;      //!< finder and alignment pattern search and sampling
+    double decoder_ms = 0;     //!< bit stream decoding and error correction
+
+    DecodeStats& operator+=(const DecodeStats& other);
+};
+
+/**
+ * @brief Time budget and cancellation of a single detectAndDecode call.
+ * The pipeline checks it between stages: before and after the detector, before every scale of
+ * every candidate, before every binarizer, before the inverted image pass and between the finder
+ * pattern and dimension retries of the reader. A call overruns the budget by at most one stage.
+ * Once stopped, the call returns the codes decoded so far.
+ */
+class DecodeControl {
+public:
+    enum Status {
+        RUNNING = 0,    //!< not stopped (yet)
+        TIMED_OUT = 1,  //!< the deadline passed
+        CANCELLED = 2   //!< the cancel flag was set
+    };
+
+    DecodeControl() = default;
+    /**
+     * @param timeout_ms time budget starting now, negative for no limit.
+     * @param cancel optional flag that cancels the call once set, must outlive the call.
+     */
+    explicit DecodeControl(int timeout_ms, const std::atomic<bool> *cancel = nullptr);
+
+    /**
+     * @brief also stop whenever parent stops, for a sub-task that can be cancelled on its own.
+     * The parent must outlive this control.
+     */
+    void setParent(DecodeControl *parent);
+
+    /**
+     * @brief true when the call should stop. Once true it stays true.
+     */
+    bool shouldStop();
+    Status status() const { return static_cast<Status>(status_.load(std::memory_order_relaxed)); }
+
+private:
+    std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool> *cancel_ = nullptr;
+    DecodeControl *parent_ = nullptr;
+    std::atomic<int> status_{RUNNING};
+};
+
+/**
+ * @brief Tracking state of a video stream, carried from frame to frame by
+ * WeChatQRCode::detectAndDecodeStream. One state per stream, not shared between threads.
+ */
+struct StreamState {
+    //! run the full pipeline at least every this many frames, 0 to only do so when tracking is lost
+    int refresh_interval = 30;
+    //! margin added around a tracked code when searching the next frame, relative to the code size
+    float roi_expand = 0.25f;
+    //! vertices of the codes decoded in the previous frame, empty when nothing is tracked
+    std::vector<cv::Mat> tracked_points;
+    //! frames decoded from tracked regions since the last full pipeline run
+    int frames_since_refresh = 0;
+};
+
+/**
+ * @brief Buffers kept from one detectAndDecode call to the next by a caller decoding a batch of
+ * images in turn: the CNN detector's resized input and the pools its network allocates from. One
+ * per thread, not shared between concurrent calls.
+ */
+class DecodeScratch {
+public:
+    DecodeScratch();
+    ~DecodeScratch();
+    DecodeScratch(const DecodeScratch&) = delete;
+    DecodeScratch& operator=(const DecodeScratch&) = delete;
+
+private:
+    friend class WeChatQRCode;
+    struct Buffers;
+    std::unique_ptr<Buffers> buffers_;
+};
+
 /**
  * @brief  WeChat QRCode includes two CNN-based models:
  * A object detection model and a super resolution model.
@@ -24,10 +129,51 @@ namespace wechat_qrcode {
  */
 class WeChatQRCode {
 public:
+    /**
+     * @brief Pipeline configuration, see WeChatQRCode(const Options&).
+     */
+    struct Options {
+        //! run the CNN detector, otherwise the whole image is decoded as a single candidate
+        bool use_nn_detector = true;
+        //! upscale small candidates with the super resolution model, otherwise bicubic resizing
+        bool use_nn_sr = true;
+        //! binarizers to try in order (BinarizerMgr::BINARIZER values), empty for all four
+        std::vector<int> binarizers;
+        //! scales to try for every candidate, empty for the size based default ladder
+        std::vector<float> scales;
+        //! area in pixels the image is resized to before running the CNN detector
+        float detector_target_area = 400.f * 400.f;
+        //! ncnn threads used by each detector and super resolution inference
+        int num_threads = 1;
+        //! runs body(i) for every i in [0, count), possibly concurrently, and returns once all are
+        //! done. Used to decode the detector candidates in parallel, empty to decode them in turn.
+        std::function<void(int count, const std::function<void(int)>& body)> parallel_for;
+        //! try all scales of a candidate at once through parallel_for and cancel the later ones as
+        //! soon as one succeeds. Trades CPU time for the latency of the slowest single attempt.
+        bool speculative_scales = false;
+        //! run the binarizers of a decode attempt at once through parallel_for, the first one in
+        //! order that succeeds cancels the ones after it
+        bool parallel_binarizers = false;
+        //! learn which binarizer succeeds most cheaply per image size and try it first
+        bool adaptive_binarizers = false;
+        //! start the scale ladder of every candidate at the scale its estimated module size calls
+        //! for, refined by which scales succeeded for similar codes on this detector. Configured
+        //! scales are only reordered, never added to
+        bool adaptive_scales = false;
+        //! stop once this many codes are decoded, 0 for no limit. With parallel candidates the
+        //! returned codes may differ between runs when the image holds more than this many
+        int max_results = 0;
+    };
+
     /**
      * @brief Initialize the WeChatQRCode.
      */
     WeChatQRCode();
+    /**
+     * @brief Initialize the WeChatQRCode with the given pipeline configuration. Models of
+     * disabled stages are not loaded.
+     */
+    explicit WeChatQRCode(const Options& options);
     ~WeChatQRCode(){};
 
     /**
@@ -40,6 +186,75 @@ public:
      * @return list of decoded string.
      */
     std::vector<std::string> detectAndDecode(cv::Mat &img, std::vector<cv::Mat> &points);
+    /**
+     * @brief  Both detects and decodes QR code, also returning the raw bytes of each code.
+     *
+     * @param img supports grayscale or color (BGR) image.
+     * @param points optional output array of vertices of the found QR code quadrangle. Will be
+     * empty if not found.
+     * @param raw_bytes output array of the raw data codewords of each decoded QR code, in the same
+     * order as the returned strings.
+     * @param stats optional, the timings and counters of this call are added to it. Stages are only
+     * timed when it is given.
+     * @param control optional time budget and cancellation, see DecodeControl::status for whether
+     * the call stopped early.
+     * @param scratch optional buffers reused from the previous call, see DecodeScratch.
+     * @return list of decoded string.
+     */
+    std::vector<std::string> detectAndDecode(cv::Mat &img, std::vector<cv::Mat> &points,
+                                             std::vector<std::vector<uint8_t>> &raw_bytes,
+                                             DecodeStats *stats = nullptr, DecodeControl *control = nullptr,
+                                             DecodeScratch *scratch = nullptr);
+    /**
+     * @brief  Detects and decodes QR codes in 8-bit gray pixels owned by the caller, which are
+     * only read and must stay unchanged until the call returns.
+     *
+     * @param gray first pixel of the image.
+     * @param step bytes from one row to the next, at least width.
+     * Other parameters as for detectAndDecode of a Mat.
+     */
+    std::vector<std::string> detectAndDecode(const uchar *gray, int width, int height, size_t step,
+                                             std::vector<cv::Mat> &points,
+                                             std::vector<std::vector<uint8_t>> &raw_bytes,
+                                             DecodeStats *stats = nullptr, DecodeControl *control = nullptr,
+                                             DecodeScratch *scratch = nullptr);
+
+    /**
+     * @brief  Detects and decodes QR codes in a frame of a video stream.
+     * The regions around the codes found in the previous frame are decoded first, skipping the
+     * CNN detector. The full pipeline only runs when that finds fewer codes than were tracked,
+     * when nothing is tracked, or every state.refresh_interval frames.
+     *
+     * @param img supports grayscale or color (BGR) image.
+     * @param state tracking state of the stream, updated with the codes of this frame.
+     * @param points output array of vertices of the found QR code quadrangle.
+     * @param raw_bytes output array of the raw data codewords of each decoded QR code.
+     * @param stats optional, the timings and counters of this call are added to it.
+     * @param control optional time budget and cancellation. A frame that stops early keeps the
+     * previous tracking state.
+     * @return list of decoded string.
+     */
+    std::vector<std::string> detectAndDecodeStream(cv::Mat &img, StreamState &state, std::vector<cv::Mat> &points,
+                                                   std::vector<std::vector<uint8_t>> &raw_bytes,
+                                                   DecodeStats *stats = nullptr, DecodeControl *control = nullptr);
+    /**
+     * @brief  detectAndDecodeStream of 8-bit gray pixels owned by the caller and only read, with
+     * rows step bytes apart.
+     */
+    std::vector<std::string> detectAndDecodeStream(const uchar *gray, int width, int height, size_t step,
+                                                   StreamState &state, std::vector<cv::Mat> &points,
+                                                   std::vector<std::vector<uint8_t>> &raw_bytes,
+                                                   DecodeStats *stats = nullptr, DecodeControl *control = nullptr);
+    /**
+     * @brief the binarizer observations of an adaptive_binarizers detector as text, empty
+     * otherwise. Feed it to loadBinarizerStats of a later detector to start from what was learned.
+     */
+    std::string saveBinarizerStats();
+    /**
+     * @brief replace the binarizer observations with text produced by saveBinarizerStats.
+     * @return false if the detector is not adaptive or the text is malformed.
+     */
+    bool loadBinarizerStats(const std::string &text);
 
     /**
     * @brief set scale factor
@@ -0,0 +1,101 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+#include "precomp.hpp"
+#include "binarizer_stats.hpp"
+#include <sstream>
+
+namespace cv {
+namespace wechat_qrcode {
+int BinarizerStats::sizeClass(int width, int height) {
+    // side of the equivalent square: up to 128, 256, 512 and above
+    int side = static_cast<int>(sqrt(static_cast<double>(width) * height));
+    if (side <= 128) return 0;
+    if (side <= 256) return 1;
+    if (side <= 512) return 2;
+    return 3;
+}
+
+vector<BinarizerMgr::BINARIZER> BinarizerStats::order(int width, int height,
+                                                      const vector<BinarizerMgr::BINARIZER>& base) {
+    int size_class = sizeClass(width, height);
+    vector<std::pair<double, BinarizerMgr::BINARIZER>> scored;
+    {
+        std::lock_guard<std::mutex> g(mutex_);
+        // binarizers without observations are assumed to take the mean time of the observed ones
+        double observed_ms = 0;
+        long long observed_attempts = 0;
+        for (const Entry& entry : entries_[size_class]) {
+            observed_ms += entry.ms;
+            observed_attempts += entry.attempts;
+        }
+        double default_ms = observed_attempts > 0 ? observed_ms / observed_attempts : 0;
+        for (auto binarizer : base) {
+            const Entry& entry = entries_[size_class][binarizer];
+            // Laplace smoothed success rate over mean time, which is the order that minimizes the
+            // expected time to the first success. Without any data every binarizer scores the same
+            // and the base order holds.
+            double rate = (entry.successes + 1.0) / (entry.attempts + 2.0);
+            double mean_ms = entry.attempts > 0 ? entry.ms / entry.attempts : default_ms;
+            scored.emplace_back(rate / (mean_ms + 1.0), binarizer);
+        }
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<double, BinarizerMgr::BINARIZER>& a,
+                        const std::pair<double, BinarizerMgr::BINARIZER>& b) { return a.first > b.first; });
+    vector<BinarizerMgr::BINARIZER> ordered;
+    for (const auto& item : scored) ordered.push_back(item.second);
+    return ordered;
+}
+
+void BinarizerStats::record(int width, int height, BinarizerMgr::BINARIZER binarizer, bool success, double ms) {
+    if (binarizer < 0 || static_cast<int>(binarizer) >= BINARIZER_COUNT) return;
+    std::lock_guard<std::mutex> g(mutex_);
+    Entry& entry = entries_[sizeClass(width, height)][binarizer];
+    entry.attempts++;
+    if (success) entry.successes++;
+    entry.ms += ms;
+}
+
+std::string BinarizerStats::save() {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> g(mutex_);
+    for (int size_class = 0; size_class < SIZE_CLASS_COUNT; size_class++) {
+        for (int binarizer = 0; binarizer < BINARIZER_COUNT; binarizer++) {
+            const Entry& entry = entries_[size_class][binarizer];
+            out << size_class << ' ' << binarizer << ' ' << entry.attempts << ' ' << entry.successes << ' '
+                << entry.ms << '\n';
+        }
+    }
+    return out.str();
+}
+
+bool BinarizerStats::load(const std::string& text) {
+    Entry loaded[SIZE_CLASS_COUNT][BINARIZER_COUNT];
+    std::istringstream in(text);
+    int size_class, binarizer;
+    Entry entry;
+    // a record either reads in full or is not started at all, since the text ran out before it
+    while (!(in >> std::ws).eof()) {
+        if (!(in >> size_class >> binarizer >> entry.attempts >> entry.successes >> entry.ms)) return false;
+        if (size_class < 0 || size_class >= SIZE_CLASS_COUNT || binarizer < 0 || binarizer >= BINARIZER_COUNT ||
+            entry.attempts < 0 || entry.successes < 0 || entry.successes > entry.attempts || !(entry.ms >= 0)) {
+            return false;
+        }
+        loaded[size_class][binarizer] = entry;
+    }
+
+    std::lock_guard<std::mutex> g(mutex_);
+    std::copy(&loaded[0][0], &loaded[0][0] + SIZE_CLASS_COUNT * BINARIZER_COUNT, &entries_[0][0]);
+    return true;
+}
+
+void BinarizerStats::reset() {
+    std::lock_guard<std::mutex> g(mutex_);
+    std::fill(&entries_[0][0], &entries_[0][0] + SIZE_CLASS_COUNT * BINARIZER_COUNT, Entry());
+}
+}  // namespace wechat_qrcode
+}  // namespace cv
@@ -0,0 +1,60 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __OPENCV_WECHAT_QRCODE_BINARIZER_STATS_HPP__
+#define __OPENCV_WECHAT_QRCODE_BINARIZER_STATS_HPP__
+#include <mutex>
+#include <string>
+#include <vector>
+#include "binarizermgr.hpp"
+namespace cv {
+namespace wechat_qrcode {
+/**
+ * @brief Success and latency of every binarizer per image size class, observed over the lifetime
+ * of a detector and used to try the likeliest winner first. Shared by all threads decoding with
+ * the detector.
+ */
+class BinarizerStats {
+public:
+    enum { SIZE_CLASS_COUNT = 4, BINARIZER_COUNT = 4 };
+
+    /**
+     * @brief base reordered by expected payoff, success rate over mean time, for an image of the
+     * given size. Binarizers without observations keep their relative order.
+     */
+    std::vector<BinarizerMgr::BINARIZER> order(int width, int height,
+                                               const std::vector<BinarizerMgr::BINARIZER>& base);
+    /**
+     * @brief record one finished attempt. Cancelled attempts must not be recorded.
+     */
+    void record(int width, int height, BinarizerMgr::BINARIZER binarizer, bool success, double ms);
+
+    /**
+     * @brief text form of the counters, one "size_class binarizer attempts successes ms" line each.
+     */
+    std::string save();
+    /**
+     * @brief replace the counters with ones produced by save.
+     * @return false and leave the counters unchanged if text is malformed.
+     */
+    bool load(const std::string& text);
+    void reset();
+
+private:
+    struct Entry {
+        long long attempts = 0;
+        long long successes = 0;
+        double ms = 0;
+    };
+    static int sizeClass(int width, int height);
+
+    std::mutex mutex_;
+    Entry entries_[SIZE_CLASS_COUNT][BINARIZER_COUNT];
+};
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __OPENCV_WECHAT_QRCODE_BINARIZER_STATS_HPP__
@@ -27,7 +27,10 @@ zxing::Ref<Binarizer> BinarizerMgr::Binarize(zxing::Ref<LuminanceSource> source)
     if (m_iNextOnceBinarizer >= 0) {
         binarizerIdx = (BINARIZER)m_iNextOnceBinarizer;
     }
+    return Create(binarizerIdx, source);
+}
 
+zxing::Ref<Binarizer> BinarizerMgr::Create(BINARIZER binarizerIdx, zxing::Ref<LuminanceSource> source) {
     zxing::Ref<Binarizer> binarizer;
     switch (binarizerIdx) {
         case Hybrid:
@@ -65,6 +68,7 @@ void BinarizerMgr::SetNextOnceBinarizer(int iBinarizerIndex) {
 
 void BinarizerMgr::SetBinarizer(vector<BINARIZER> vecRotateBinarizer) {
     m_vecRotateBinarizer = vecRotateBinarizer;
+    m_iNowRotateIndex = 0;
 }
 }  // namespace wechat_qrcode
 }  // namespace cv
\ No newline at end of file
@@ -33,12 +33,15 @@ public:
 
     zxing::Ref<zxing::Binarizer> Binarize(zxing::Ref<zxing::LuminanceSource> source);
 
+    static zxing::Ref<zxing::Binarizer> Create(BINARIZER binarizerIdx, zxing::Ref<zxing::LuminanceSource> source);
+
     void SwitchBinarizer();
 
     int GetCurBinarizer();
 
     void SetNextOnceBinarizer(int iBinarizerIndex);
 
+    // Replace the rotation, which restarts at its first binarizer.
     void SetBinarizer(vector<BINARIZER> vecRotateBinarizer);
 
 private:
@@ -6,6 +6,7 @@
 // Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
 #include "precomp.hpp"
 #include "decodermgr.hpp"
+#include "stats_timer.hpp"
 
 
 using zxing::ArrayRef;
@@ -18,67 +19,205 @@ using zxing::Result;
 using zxing::UnicomBlock;
 namespace cv {
 namespace wechat_qrcode {
-int DecoderMgr::decodeImage(cv::Mat src, bool use_nn_detector, vector<string>& results, vector<vector<Point2f>>& zxing_points) {
+static void appendResults(const vector<Ref<Result>>& zx_results, vector<string>& results,
+                          vector<vector<Point2f>>& zxing_points, vector<vector<uint8_t>>& raw_bytes) {
+    for (size_t k = 0; k < zx_results.size(); k++) {
+        results.emplace_back(zx_results[k]->getText()->getText());
+        auto zx_raw_bytes = zx_results[k]->getRawBytes();
+        if (zx_raw_bytes) {
+            raw_bytes.emplace_back(zx_raw_bytes->values().begin(), zx_raw_bytes->values().end());
+        } else {
+            raw_bytes.emplace_back();
+        }
+        vector<Point2f> tmp_qr_points;
+        auto tmp_zx_points = zx_results[k]->getResultPoints();
+        for (int i = 0; i < tmp_zx_points->size(); i++) {
+            tmp_qr_points.emplace_back(tmp_zx_points[i]->getX(), tmp_zx_points[i]->getY());
+        }
+        zxing_points.push_back(tmp_qr_points);
+    }
+}
+
+int DecoderMgr::decodeImage(const ImageView& src, bool use_nn_detector, vector<string>& results, vector<vector<Point2f>>& zxing_points,
+                            vector<vector<uint8_t>>& raw_bytes, DecodeStats* stats, DecodeControl* control) {
     int width = src.cols;
     int height = src.rows;
     if (width <= 20 || height <= 20)
         return -1;  // image data is not enough for providing reliable results
 
-    std::vector<uint8_t> scaled_img_data(src.data, src.data + width * height);
-    zxing::ArrayRef<uint8_t> scaled_img_zx =
-        zxing::ArrayRef<uint8_t>(new zxing::Array<uint8_t>(scaled_img_data));
-
-    vector<zxing::Ref<zxing::Result>> zx_results;
+    // Every call starts the rotation over. A pooled DecoderMgr would otherwise go on from wherever
+    // its previous call stopped, a success or a deadline, and the order would depend on pool history.
+    binarizer_mgr_.SetBinarizer(binarizer_stats_ ? binarizer_stats_->order(width, height, binarizers_)
+                                                 : binarizers_);
+    if (parallel_for_ && binarizer_count_ > 1) {
+        return decodeParallel(src, use_nn_detector, results, zxing_points, raw_bytes, stats, control);
+    }
 
     decode_hints_.setUseNNDetector(use_nn_detector);
+    decode_hints_.setControl(control);
+    decode_hints_.setMaxResults(max_results_);
+    reader_->setCollectTimes(stats != nullptr);
 
-    Ref<ImgSource> source;
-    qbarUicomBlock_ = new UnicomBlock(height, width);
+    // The binarizers only read the luminance matrix, so one source built straight from src serves all of them.
+    Ref<ImgSource> source =
+        ImgSource::create(src.data, width, height, static_cast<int>(src.step));
+    if (qbarUicomBlock_.empty()) {
+        qbarUicomBlock_ = new UnicomBlock(height, width);
+    } else {
+        qbarUicomBlock_->Resize(height, width);
+    }
 
-    // Four Binarizers
-    int tryBinarizeTime = 4;
+    // Four Binarizers unless configured otherwise
+    int tryBinarizeTime = binarizer_count_;
     for (int tb = 0; tb < tryBinarizeTime; tb++) {
-        if (source == NULL || height * width > source->getMaxSize()) {
-            source = ImgSource::create(scaled_img_zx.data(), width, height);
-        } else {
-            source->reset(scaled_img_zx.data(), width, height);
+        if (control && control->shouldStop()) break;
+        StatsTimer timer(stats != nullptr || binarizer_stats_ != nullptr);
+        int ret = TryDecode(source, results, zxing_points, raw_bytes);
+        int binarizer = binarizer_mgr_.GetCurBinarizer();
+        double ms = timer.lap();
+        if (stats) {
+            if (binarizer >= 0 && binarizer < DecodeStats::BINARIZER_COUNT) {
+                stats->binarizer_attempts[binarizer]++;
+                stats->binarizer_ms[binarizer] += ms;
+                if (!ret) stats->binarizer_successes[binarizer]++;
+            }
+        }
+        // an attempt cut short by the deadline says nothing about the binarizer
+        if (binarizer_stats_ && (!control || control->status() == DecodeControl::RUNNING)) {
+            binarizer_stats_->record(width, height, static_cast<BinarizerMgr::BINARIZER>(binarizer), !ret, ms);
         }
-        int ret = TryDecode(source, zx_results);
         if (!ret) {
-            for(size_t k = 0; k < zx_results.size(); k++) {
-                results.emplace_back(zx_results[k]->getText()->getText());
-                vector<Point2f> tmp_qr_points;
-                auto tmp_zx_points = zx_results[k]->getResultPoints();
-                for (int i = 0; i < tmp_zx_points->size(); i++) {
-                    tmp_qr_points.emplace_back(tmp_zx_points[i]->getX(), tmp_zx_points[i]->getY());
-                }
-                zxing_points.push_back(tmp_qr_points);
-            }
+            collectReaderTimes(stats);
             return ret;
         }
         // try different binarizers
         binarizer_mgr_.SwitchBinarizer();
     }
+    collectReaderTimes(stats);
     return -1;
 }
 
-int DecoderMgr::TryDecode(Ref<LuminanceSource> source, vector<Ref<Result>>& results) {
-    int res = -1;
-    string cell_result;
+void DecoderMgr::setBinarizers(const vector<BinarizerMgr::BINARIZER>& binarizers) {
+    binarizers_ = binarizers;
+    binarizer_mgr_.SetBinarizer(binarizers);
+    binarizer_count_ = static_cast<int>(binarizers.size());
+}
+
+void DecoderMgr::setParallelFor(const std::function<void(int, const std::function<void(int)>&)>& parallel_for) {
+    parallel_for_ = parallel_for;
+}
+
+int DecoderMgr::decodeParallel(const ImageView& src, bool use_nn_detector, vector<string>& results,
+                               vector<vector<Point2f>>& zxing_points, vector<vector<uint8_t>>& raw_bytes,
+                               DecodeStats* stats, DecodeControl* control) {
+    int width = src.cols;
+    int height = src.rows;
+    // Same order the serial loop would try them in, the rotation ends where it started.
+    vector<BinarizerMgr::BINARIZER> order;
+    for (int tb = 0; tb < binarizer_count_; tb++) {
+        order.push_back(static_cast<BinarizerMgr::BINARIZER>(binarizer_mgr_.GetCurBinarizer()));
+        binarizer_mgr_.SwitchBinarizer();
+    }
+
+    // zxing objects are not thread safe, so every attempt works on its own from the shared pixels and
+    // only hands its results back once parallel_for has joined.
+    struct Attempt {
+        bool ran = false;
+        bool completed = false;  // ran to the end without being cancelled
+        bool succeeded = false;
+        vector<string> texts;
+        vector<vector<Point2f>> points;
+        vector<vector<uint8_t>> raw_bytes;
+        double ms = 0;
+        double finder_ms = 0;
+        double decoder_ms = 0;
+    };
+    int count = static_cast<int>(order.size());
+    // the readers and UnicomBlocks stay with this DecoderMgr for its next calls, one per attempt
+    while (static_cast<int>(parallel_readers_.size()) < count) {
+        parallel_readers_.push_back(Ref<zxing::qrcode::QRCodeReader>(new zxing::qrcode::QRCodeReader()));
+        parallel_blocks_.push_back(Ref<UnicomBlock>(new UnicomBlock(height, width)));
+    }
+    for (int i = 0; i < count; i++) parallel_blocks_[i]->Resize(height, width);
+    vector<Attempt> attempts(count);
+    vector<std::atomic<bool>> cancelled(count);
+    for (auto& flag : cancelled) flag.store(false);
+    parallel_for_(count, [&](int i) {
+        DecodeControl attempt_control(-1, &cancelled[i]);
+        attempt_control.setParent(control);
+        if (attempt_control.shouldStop()) return;
+        zxing::ArenaScope arena;
+        StatsTimer timer(stats != nullptr || binarizer_stats_ != nullptr);
+        Ref<ImgSource> source =
+            ImgSource::create(src.data, width, height, static_cast<int>(src.step));
+        Ref<zxing::qrcode::QRCodeReader> reader = parallel_readers_[i];
+        reader->setCollectTimes(stats != nullptr);
+        Ref<BinaryBitmap> binary_bitmap(new BinaryBitmap(BinarizerMgr::Create(order[i], source)));
+        binary_bitmap->m_poUnicomBlock = parallel_blocks_[i];
+        DecodeHints hints(use_nn_detector);
+        hints.setControl(&attempt_control);
+        hints.setMaxResults(max_results_);
+
+        Attempt& attempt = attempts[i];
+        attempt.ran = true;
+        vector<Ref<Result>> zx_results = reader->decode(binary_bitmap, hints);
+        parallel_blocks_[i]->ReleaseImage();
+        attempt.succeeded = !zx_results.empty();
+        if (attempt.succeeded) {
+            appendResults(zx_results, attempt.texts, attempt.points, attempt.raw_bytes);
+            for (int j = i + 1; j < count; j++) cancelled[j].store(true);
+        }
+        attempt.completed = attempt_control.status() == DecodeControl::RUNNING;
+        attempt.ms = timer.lap();
+        attempt.finder_ms = reader->getFinderTime();
+        attempt.decoder_ms = reader->getDecoderTime();
+    });
+
+    int ret = -1;
+    for (int i = 0; i < count; i++) {
+        Attempt& attempt = attempts[i];
+        if (stats && attempt.ran) {
+            stats->binarizer_attempts[order[i]]++;
+            stats->binarizer_ms[order[i]] += attempt.ms;
+            stats->finder_ms += attempt.finder_ms;
+            stats->decoder_ms += attempt.decoder_ms;
+            if (attempt.succeeded) stats->binarizer_successes[order[i]]++;
+        }
+        if (binarizer_stats_ && attempt.completed) {
+            binarizer_stats_->record(width, height, order[i], attempt.succeeded, attempt.ms);
+        }
+        if (ret != 0 && attempt.succeeded) {
+            results.insert(results.end(), attempt.texts.begin(), attempt.texts.end());
+            zxing_points.insert(zxing_points.end(), attempt.points.begin(), attempt.points.end());
+            raw_bytes.insert(raw_bytes.end(), attempt.raw_bytes.begin(), attempt.raw_bytes.end());
+            ret = 0;
+        }
+    }
+    return ret;
+}
+
+void DecoderMgr::collectReaderTimes(DecodeStats* stats) {
+    if (stats) {
+        stats->finder_ms += reader_->getFinderTime();
+        stats->decoder_ms += reader_->getDecoderTime();
+    }
+}
+
+int DecoderMgr::TryDecode(Ref<LuminanceSource> source, vector<string>& results,
+                          vector<vector<Point2f>>& zxing_points, vector<vector<uint8_t>>& raw_bytes) {
+    // the attempt's zxing objects come from this thread's arena, see zxing/common/arena.hpp
+    zxing::ArenaScope arena;
 
     // get binarizer
     zxing::Ref<zxing::Binarizer> binarizer = binarizer_mgr_.Binarize(source);
     zxing::Ref<zxing::BinaryBitmap> binary_bitmap(new BinaryBitmap(binarizer));
     binary_bitmap->m_poUnicomBlock = qbarUicomBlock_;
 
-    results = Decode(binary_bitmap, decode_hints_);
-    res = (results.size() == 0) ? 1 : 0;
-
-    if (res == 0) {
-        results[0]->setBinaryMethod(int(binarizer_mgr_.GetCurBinarizer()));
-    }
-
-    return res;
+    vector<Ref<Result>> zx_results = Decode(binary_bitmap, decode_hints_);
+    qbarUicomBlock_->ReleaseImage();
+    if (zx_results.empty()) return 1;
+    appendResults(zx_results, results, zxing_points, raw_bytes);
+    return 0;
 }
 
 vector<Ref<Result>> DecoderMgr::Decode(Ref<BinaryBitmap> image, DecodeHints hints) {
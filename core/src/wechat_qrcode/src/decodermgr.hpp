@@ -16,9 +16,13 @@
 #include "zxing/result.hpp"
 
 // qbar
+#include "binarizer_stats.hpp"
 #include "binarizermgr.hpp"
+#include "image_view.hpp"
 #include "imgsource.hpp"
 
+#include <functional>
+#include "opencv2/wechat_qrcode.hpp"
 #include "simpleocv.h"
 
 namespace cv {
@@ -29,7 +33,32 @@ public:
     DecoderMgr() { reader_ = new zxing::qrcode::QRCodeReader(); };
     ~DecoderMgr(){};
 
-    int decodeImage(cv::Mat src, bool use_nn_detector, vector<string>& result, vector<vector<Point2f>>& zxing_points);
+    int decodeImage(const ImageView& src, bool use_nn_detector, vector<string>& result, vector<vector<Point2f>>& zxing_points,
+                    vector<vector<uint8_t>>& raw_bytes, DecodeStats* stats = nullptr,
+                    DecodeControl* control = nullptr);
+
+    /**
+     * @brief binarizers to try in order, replacing the default rotation of all four.
+     */
+    void setBinarizers(const vector<BinarizerMgr::BINARIZER>& binarizers);
+
+    /**
+     * @brief run the binarizers concurrently through parallel_for, each with its own source,
+     * UnicomBlock and reader. The first binarizer in order that succeeds wins and cancels the ones
+     * after it. Empty to try them one after another.
+     */
+    void setParallelFor(const std::function<void(int, const std::function<void(int)>&)>& parallel_for);
+
+    /**
+     * @brief order the binarizers of every decodeImage call by the observations in binarizer_stats
+     * and record the outcome of each attempt there. Null to keep the configured order.
+     */
+    void setBinarizerStats(BinarizerStats* binarizer_stats) { binarizer_stats_ = binarizer_stats; }
+
+    /**
+     * @brief stop combining finder patterns once this many codes are decoded, 0 for no limit.
+     */
+    void setMaxResults(int max_results) { max_results_ = max_results; }
 
 private:
     zxing::Ref<zxing::UnicomBlock> qbarUicomBlock_;
@@ -37,11 +66,30 @@ private:
 
     zxing::Ref<zxing::qrcode::QRCodeReader> reader_;
     BinarizerMgr binarizer_mgr_;
+    int binarizer_count_ = 4;
+    vector<BinarizerMgr::BINARIZER> binarizers_ = {BinarizerMgr::Hybrid, BinarizerMgr::FastWindow,
+                                                   BinarizerMgr::SimpleAdaptive, BinarizerMgr::AdaptiveThreshold};
+    BinarizerStats* binarizer_stats_ = nullptr;
+    // scratch of the attempts of decodeParallel, by attempt index
+    vector<zxing::Ref<zxing::qrcode::QRCodeReader>> parallel_readers_;
+    vector<zxing::Ref<zxing::UnicomBlock>> parallel_blocks_;
+    int max_results_ = 0;
 
     vector<zxing::Ref<zxing::Result>> Decode(zxing::Ref<zxing::BinaryBitmap> image,
                                      zxing::DecodeHints hints);
 
-    int TryDecode(zxing::Ref<zxing::LuminanceSource> source, vector<zxing::Ref<zxing::Result>>& result);
+    // Both append the decoded codes to the output vectors before their ArenaScope closes, so no zxing object of an
+    // attempt outlives it and the arena chunk can start over, see zxing/common/arena.hpp.
+    int TryDecode(zxing::Ref<zxing::LuminanceSource> source, vector<string>& result,
+                  vector<vector<Point2f>>& zxing_points, vector<vector<uint8_t>>& raw_bytes);
+
+    void collectReaderTimes(DecodeStats* stats);
+
+    int decodeParallel(const ImageView& src, bool use_nn_detector, vector<string>& result,
+                       vector<vector<Point2f>>& zxing_points, vector<vector<uint8_t>>& raw_bytes, DecodeStats* stats,
+                       DecodeControl* control);
+
+    std::function<void(int, const std::function<void(int)>&)> parallel_for_;
 };
 
 }  // namespace wechat_qrcode
@@ -12,12 +12,12 @@ using std::min;
 namespace cv {
 namespace wechat_qrcode {
 
-static Mat transposeMat(const Mat &src) {
-    Mat dst(src.cols, src.rows, src.type());
-    size_t elemSize = src.type(); // Number of bytes per element
+static Mat transposeMat(const ImageView &src) {
+    Mat dst(src.cols, src.rows, CV_8UC1);
+    size_t elemSize = 1; // Number of bytes per element
 
     for (int i = 0; i < src.rows; ++i) {
-        const uchar *srcRow = src.ptr<uchar>(i); // Source matrix row pointer
+        const uchar *srcRow = src.ptr(i); // Source matrix row pointer
         for (int j = 0; j < src.cols; ++j) {
             const uchar *srcElem = srcRow + j * elemSize; // Address of (i,j) in source
             uchar *dstElem = dst.ptr<uchar>(j) + i * elemSize; // Address of (j,i) in destination
@@ -40,8 +40,8 @@ vector<Point2f> Align::warpBack(const vector<Point2f> &dst_pts) {
     return src_pts;
 }
 
-Mat Align::crop(const Mat &inputImg, const Mat &srcPts, const float paddingW, const float paddingH,
-                const int minPadding) {
+ImageView Align::crop(const ImageView &inputImg, const Mat &srcPts, const float paddingW, const float paddingH,
+                      const int minPadding, Mat &rotated) {
     int x0 = srcPts.ptr<float>(0)[0];
     int y0 = srcPts.ptr<float>(0)[1];
     int x2 = srcPts.ptr<float>(2)[0];
@@ -60,8 +60,11 @@ Mat Align::crop(const Mat &inputImg, const Mat &srcPts, const float paddingW, co
 
     Rect crop_roi(crop_x_, crop_y_, (end_x - crop_x_ + 1) & -2, (end_y - crop_y_ + 1) & -2);
 
-    Mat dst = inputImg(crop_roi).clone();
-    if (rotate90_) dst = transposeMat(dst);  // transpose
+    ImageView dst = inputImg(crop_roi);
+    if (rotate90_) {  // transpose
+        rotated = transposeMat(dst);
+        dst = ImageView(rotated);
+    }
     return dst;
 }
 
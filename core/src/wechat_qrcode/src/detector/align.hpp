@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <fstream>
+#include "../image_view.hpp"
 #include "simpleocv.h"
 
 namespace cv {
@@ -19,8 +20,12 @@ class Align {
 public:
     Align();
     std::vector<Point2f> warpBack(const std::vector<Point2f> &dst_pts);
-    Mat crop(const Mat &inputImg, const Mat &srcPts, const float paddingW, const float paddingH,
-             const int minPadding);
+    /**
+     * @brief the padded candidate region of inputImg as a view into it. Only a rotated crop
+     * copies, into rotated, which the view then points to.
+     */
+    ImageView crop(const ImageView &inputImg, const Mat &srcPts, const float paddingW, const float paddingH,
+                   const int minPadding, Mat &rotated);
 
     void setRotate90(bool v) { rotate90_ = v; }
 
@@ -6,6 +6,7 @@
 // Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
 #include "../precomp.hpp"
 #include "ssd_detector.hpp"
+#include "../model_store.hpp"
 #ifdef DETECT_USE_OPT_MODEL
 #include "detect_opt.id.h"
 #include "detect_opt.mem.h"
@@ -15,23 +16,37 @@
 #endif
 namespace cv {
 namespace wechat_qrcode {
-int SSDDetector::init() {
-    net_.opt.num_threads = 1;
-    net_.load_param(detect_param_bin);
-    net_.load_model(detect_bin);
+static void loadDetectModel(ncnn::Net& net) {
+    net.opt.num_threads = 1;
+    net.load_param(detect_param_bin);
+    net.load_model(detect_bin);
+}
+
+int SSDDetector::init(int num_threads) {
+    net_ = ModelStore::acquire("detect", loadDetectModel);
+    num_threads_ = num_threads;
     return 0;
 }
 
-vector<Mat> SSDDetector::forward(Mat img, const int target_width, const int target_height) {
+vector<Mat> SSDDetector::forward(const ImageView& img, const int target_width, const int target_height,
+                                 Session* session) {
     int img_w = img.cols;
     int img_h = img.rows;
-    ncnn::Mat ncnn_img = ncnn::Mat::from_pixels(img.data, ncnn::Mat::PIXEL_GRAY, img_w, img_h);
+    ncnn::Mat ncnn_img = ncnn::Mat::from_pixels(img.data, ncnn::Mat::PIXEL_GRAY, img_w, img_h, (int)img.step,
+                                                session ? &session->blob_allocator : nullptr);
 
-    ncnn::Mat ncnn_input;
+    // resize_bicubic keeps the session's input buffer when the target size is unchanged
+    ncnn::Mat local_input;
+    ncnn::Mat& ncnn_input = session ? session->input : local_input;
     ncnn::resize_bicubic(ncnn_img, ncnn_input, target_width, target_height);
     const float norm_vals[] = { 1.f / 255.f };
     ncnn_input.substract_mean_normalize(nullptr, norm_vals);
-    ncnn::Extractor ex = net_.create_extractor();
+    ncnn::Extractor ex = net_->create_extractor();
+    ex.set_num_threads(num_threads_);
+    if (session) {
+        ex.set_blob_allocator(&session->blob_allocator);
+        ex.set_workspace_allocator(&session->workspace_allocator);
+    }
     ex.input(detect_param_id::BLOB_data, ncnn_input);
 
     ncnn::Mat prob;
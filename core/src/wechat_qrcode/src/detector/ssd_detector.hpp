@@ -9,7 +9,9 @@
 #define __DETECTOR_SSD_DETECTOR_HPP_
 
 #include <stdio.h>
+#include <memory>
 
+#include "../image_view.hpp"
 #include "net.h"
 #include "simpleocv.h"
 namespace cv {
@@ -19,11 +21,28 @@ class SSDDetector {
 public:
     SSDDetector(){};
     ~SSDDetector(){};
-    int init();
-    std::vector<Mat> forward(Mat img, const int target_width, const int target_height);
+    /**
+     * @brief buffers kept from one forward call to the next by a caller running the detector on
+     * many images in turn: the resized input, and pools the network's blobs and workspace are
+     * allocated from. Used by one thread at a time.
+     */
+    struct Session {
+        ncnn::UnlockedPoolAllocator blob_allocator;
+        ncnn::PoolAllocator workspace_allocator;
+        ncnn::Mat input;
+    };
+
+    int init(int num_threads = 1);
+    /**
+     * @param session optional, reused instead of allocating the buffers of this call afresh.
+     */
+    std::vector<Mat> forward(const ImageView& img, const int target_width, const int target_height,
+                             Session* session = nullptr);
 
 private:
-    ncnn::Net net_;
+    // shared by all detector instances, see ModelStore
+    std::shared_ptr<const ncnn::Net> net_;
+    int num_threads_ = 1;
 };
 
 }  // namespace wechat_qrcode
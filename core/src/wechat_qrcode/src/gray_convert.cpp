@@ -0,0 +1,268 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#include "gray_convert.hpp"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define GRAY_CONVERT_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRAY_CONVERT_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GRAY_CONVERT_AVX2 1
+#define GRAY_CONVERT_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAY_CONVERT_AVX2 1
+#define GRAY_CONVERT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+namespace cv {
+namespace wechat_qrcode {
+
+namespace {
+// Weight of every byte of a pixel, zero for alpha. They sum to 256, so the weighted sum of 8-bit
+// channels fits an unsigned 16-bit lane.
+struct PixelWeights {
+    int size;
+    uint8_t w[4];
+};
+
+const uint8_t kWeightR = 77;
+const uint8_t kWeightG = 150;
+const uint8_t kWeightB = 29;
+
+PixelWeights weightsOf(GrayPixelLayout layout) {
+    switch (layout) {
+        case GRAY_FROM_RGB:
+            return {3, {kWeightR, kWeightG, kWeightB, 0}};
+        case GRAY_FROM_BGR:
+            return {3, {kWeightB, kWeightG, kWeightR, 0}};
+        case GRAY_FROM_RGBA:
+            return {4, {kWeightR, kWeightG, kWeightB, 0}};
+        case GRAY_FROM_BGRA:
+            return {4, {kWeightB, kWeightG, kWeightR, 0}};
+        case GRAY_FROM_ARGB:
+            return {4, {0, kWeightR, kWeightG, kWeightB}};
+        case GRAY_FROM_ABGR:
+        default:
+            return {4, {0, kWeightB, kWeightG, kWeightR}};
+    }
+}
+
+void convertRowScalar(const uint8_t* src, const PixelWeights& pw, int x, int width, uint8_t* dst) {
+    const uint8_t* p = src + (size_t)x * pw.size;
+    if (pw.size == 3) {
+        for (; x < width; x++, p += 3) {
+            dst[x] = (uint8_t)((p[0] * pw.w[0] + p[1] * pw.w[1] + p[2] * pw.w[2]) >> 8);
+        }
+    } else {
+        for (; x < width; x++, p += 4) {
+            dst[x] = (uint8_t)((p[0] * pw.w[0] + p[1] * pw.w[1] + p[2] * pw.w[2] + p[3] * pw.w[3]) >> 8);
+        }
+    }
+}
+
+#ifdef GRAY_CONVERT_NEON
+// 16 pixels per step, deinterleaved by vld3q/vld4q.
+int convertRowNeon(const uint8_t* src, const PixelWeights& pw, int width, uint8_t* dst) {
+    const uint8x8_t w0 = vdup_n_u8(pw.w[0]);
+    const uint8x8_t w1 = vdup_n_u8(pw.w[1]);
+    const uint8x8_t w2 = vdup_n_u8(pw.w[2]);
+    const uint8x8_t w3 = vdup_n_u8(pw.w[3]);
+    int x = 0;
+    if (pw.size == 3) {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x3_t v = vld3q_u8(src + x * 3);
+            uint16x8_t lo = vmull_u8(vget_low_u8(v.val[0]), w0);
+            uint16x8_t hi = vmull_u8(vget_high_u8(v.val[0]), w0);
+            lo = vmlal_u8(lo, vget_low_u8(v.val[1]), w1);
+            hi = vmlal_u8(hi, vget_high_u8(v.val[1]), w1);
+            lo = vmlal_u8(lo, vget_low_u8(v.val[2]), w2);
+            hi = vmlal_u8(hi, vget_high_u8(v.val[2]), w2);
+            vst1q_u8(dst + x, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+    } else {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x4_t v = vld4q_u8(src + x * 4);
+            uint16x8_t lo = vmull_u8(vget_low_u8(v.val[0]), w0);
+            uint16x8_t hi = vmull_u8(vget_high_u8(v.val[0]), w0);
+            lo = vmlal_u8(lo, vget_low_u8(v.val[1]), w1);
+            hi = vmlal_u8(hi, vget_high_u8(v.val[1]), w1);
+            lo = vmlal_u8(lo, vget_low_u8(v.val[2]), w2);
+            hi = vmlal_u8(hi, vget_high_u8(v.val[2]), w2);
+            lo = vmlal_u8(lo, vget_low_u8(v.val[3]), w3);
+            hi = vmlal_u8(hi, vget_high_u8(v.val[3]), w3);
+            vst1q_u8(dst + x, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+    }
+    return x;
+}
+#endif
+
+#ifdef GRAY_CONVERT_SSE2
+// Gray of the 8 pixels held in the 32-bit lanes of a and b, one per 16-bit lane. The 16-bit sums
+// may exceed the signed range, which the wrapping multiply and add and the logical shift tolerate.
+inline __m128i graySse2(__m128i a, __m128i b, const __m128i* w) {
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i c0 = _mm_packs_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    __m128i c1 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 8), mask),
+                                 _mm_and_si128(_mm_srli_epi32(b, 8), mask));
+    __m128i c2 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 16), mask),
+                                 _mm_and_si128(_mm_srli_epi32(b, 16), mask));
+    __m128i c3 = _mm_packs_epi32(_mm_srli_epi32(a, 24), _mm_srli_epi32(b, 24));
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(c0, w[0]), _mm_mullo_epi16(c1, w[1]));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(c2, w[2]));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(c3, w[3]));
+    return _mm_srli_epi16(sum, 8);
+}
+
+// Moves the four 3-byte pixels at the start of v into their own 32-bit lanes.
+inline __m128i spreadRgbSse2(__m128i v) {
+    const __m128i m0 = _mm_setr_epi32(0x00ffffff, 0, 0, 0);
+    const __m128i m1 = _mm_setr_epi32(0, 0x00ffffff, 0, 0);
+    const __m128i m2 = _mm_setr_epi32(0, 0, 0x00ffffff, 0);
+    const __m128i m3 = _mm_setr_epi32(0, 0, 0, 0x00ffffff);
+    __m128i r = _mm_and_si128(v, m0);
+    r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 1), m1));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 2), m2));
+    return _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 3), m3));
+}
+
+// 16 pixels per step starting at x.
+int convertRowSse2(const uint8_t* src, const PixelWeights& pw, int x, int width, uint8_t* dst) {
+    const __m128i w[4] = {_mm_set1_epi16(pw.w[0]), _mm_set1_epi16(pw.w[1]), _mm_set1_epi16(pw.w[2]),
+                          _mm_set1_epi16(pw.w[3])};
+    if (pw.size == 3) {
+        // every load takes 16 bytes for 12, so stop while the last one still ends inside the row
+        for (; x + 18 <= width; x += 16) {
+            const uint8_t* p = src + x * 3;
+            __m128i v0 = spreadRgbSse2(_mm_loadu_si128((const __m128i*)p));
+            __m128i v1 = spreadRgbSse2(_mm_loadu_si128((const __m128i*)(p + 12)));
+            __m128i v2 = spreadRgbSse2(_mm_loadu_si128((const __m128i*)(p + 24)));
+            __m128i v3 = spreadRgbSse2(_mm_loadu_si128((const __m128i*)(p + 36)));
+            __m128i y = _mm_packus_epi16(graySse2(v0, v1, w), graySse2(v2, v3, w));
+            _mm_storeu_si128((__m128i*)(dst + x), y);
+        }
+    } else {
+        for (; x + 16 <= width; x += 16) {
+            const uint8_t* p = src + x * 4;
+            __m128i v0 = _mm_loadu_si128((const __m128i*)p);
+            __m128i v1 = _mm_loadu_si128((const __m128i*)(p + 16));
+            __m128i v2 = _mm_loadu_si128((const __m128i*)(p + 32));
+            __m128i v3 = _mm_loadu_si128((const __m128i*)(p + 48));
+            __m128i y = _mm_packus_epi16(graySse2(v0, v1, w), graySse2(v2, v3, w));
+            _mm_storeu_si128((__m128i*)(dst + x), y);
+        }
+    }
+    return x;
+}
+#endif
+
+#ifdef GRAY_CONVERT_AVX2
+bool hasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (!os_saves_ymm) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Same as graySse2 on 16 pixels, the packing stays within 128-bit lanes.
+GRAY_CONVERT_TARGET_AVX2 inline __m256i grayAvx2(__m256i a, __m256i b, const __m256i* w) {
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    __m256i c0 = _mm256_packs_epi32(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+    __m256i c1 = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(a, 8), mask),
+                                    _mm256_and_si256(_mm256_srli_epi32(b, 8), mask));
+    __m256i c2 = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(a, 16), mask),
+                                    _mm256_and_si256(_mm256_srli_epi32(b, 16), mask));
+    __m256i c3 = _mm256_packs_epi32(_mm256_srli_epi32(a, 24), _mm256_srli_epi32(b, 24));
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(c0, w[0]), _mm256_mullo_epi16(c1, w[1]));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(c2, w[2]));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(c3, w[3]));
+    return _mm256_srli_epi16(sum, 8);
+}
+
+// Eight 3-byte pixels into their own 32-bit lanes, four from p and four from p + 12.
+GRAY_CONVERT_TARGET_AVX2 inline __m256i spreadRgbAvx2(const uint8_t* p) {
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                        _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+    return _mm256_shuffle_epi8(v, shuffle);
+}
+
+// 32 pixels per step.
+GRAY_CONVERT_TARGET_AVX2 int convertRowAvx2(const uint8_t* src, const PixelWeights& pw, int width,
+                                            uint8_t* dst) {
+    const __m256i w[4] = {_mm256_set1_epi16(pw.w[0]), _mm256_set1_epi16(pw.w[1]), _mm256_set1_epi16(pw.w[2]),
+                          _mm256_set1_epi16(pw.w[3])};
+    // the packs interleave groups of four pixels across the two 128-bit lanes, this puts them back
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    if (pw.size == 3) {
+        // the last load ends 4 bytes after its 12, so stop while it still ends inside the row
+        for (; x + 34 <= width; x += 32) {
+            const uint8_t* p = src + x * 3;
+            __m256i v0 = spreadRgbAvx2(p);
+            __m256i v1 = spreadRgbAvx2(p + 24);
+            __m256i v2 = spreadRgbAvx2(p + 48);
+            __m256i v3 = spreadRgbAvx2(p + 72);
+            __m256i y = _mm256_packus_epi16(grayAvx2(v0, v1, w), grayAvx2(v2, v3, w));
+            _mm256_storeu_si256((__m256i*)(dst + x), _mm256_permutevar8x32_epi32(y, order));
+        }
+    } else {
+        for (; x + 32 <= width; x += 32) {
+            const uint8_t* p = src + x * 4;
+            __m256i v0 = _mm256_loadu_si256((const __m256i*)p);
+            __m256i v1 = _mm256_loadu_si256((const __m256i*)(p + 32));
+            __m256i v2 = _mm256_loadu_si256((const __m256i*)(p + 64));
+            __m256i v3 = _mm256_loadu_si256((const __m256i*)(p + 96));
+            __m256i y = _mm256_packus_epi16(grayAvx2(v0, v1, w), grayAvx2(v2, v3, w));
+            _mm256_storeu_si256((__m256i*)(dst + x), _mm256_permutevar8x32_epi32(y, order));
+        }
+    }
+    return x;
+}
+#endif
+}  // namespace
+
+int grayPixelSize(GrayPixelLayout layout) { return weightsOf(layout).size; }
+
+void convertToGray(const uint8_t* src, GrayPixelLayout layout, int width, int height, size_t src_stride,
+                   uint8_t* dst, size_t dst_stride) {
+    const PixelWeights pw = weightsOf(layout);
+#ifdef GRAY_CONVERT_AVX2
+    static const bool use_avx2 = hasAvx2();
+#endif
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src_row = src + y * src_stride;
+        uint8_t* dst_row = dst + y * dst_stride;
+        int x = 0;
+#if defined(GRAY_CONVERT_NEON)
+        x = convertRowNeon(src_row, pw, width, dst_row);
+#elif defined(GRAY_CONVERT_SSE2)
+#ifdef GRAY_CONVERT_AVX2
+        if (use_avx2) x = convertRowAvx2(src_row, pw, width, dst_row);
+#endif
+        x = convertRowSse2(src_row, pw, x, width, dst_row);
+#endif
+        convertRowScalar(src_row, pw, x, width, dst_row);
+    }
+}
+
+}  // namespace wechat_qrcode
+}  // namespace cv
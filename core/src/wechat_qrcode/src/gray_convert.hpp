@@ -0,0 +1,47 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __OPENCV_WECHAT_QRCODE_GRAY_CONVERT_HPP__
+#define __OPENCV_WECHAT_QRCODE_GRAY_CONVERT_HPP__
+#include <cstddef>
+#include <cstdint>
+namespace cv {
+namespace wechat_qrcode {
+
+enum GrayPixelLayout {
+    GRAY_FROM_RGB,
+    GRAY_FROM_BGR,
+    GRAY_FROM_RGBA,
+    GRAY_FROM_BGRA,
+    GRAY_FROM_ARGB,
+    GRAY_FROM_ABGR,
+};
+
+/**
+ * @brief convert 8-bit color pixels straight to 8-bit gray with Y = (77 R + 150 G + 29 B) >> 8,
+ * the fixed point weights ncnn's PIXEL_*2GRAY conversions use, so results match them exactly.
+ * Uses NEON, AVX2 or SSE2 when available, picking AVX2 at runtime.
+ *
+ * @param src first pixel of the image
+ * @param layout channel order of src
+ * @param width width in pixels
+ * @param height height in pixels
+ * @param src_stride bytes between rows of src, at least width times the pixel size
+ * @param dst first pixel of the gray output
+ * @param dst_stride bytes between rows of dst, at least width
+ */
+void convertToGray(const uint8_t* src, GrayPixelLayout layout, int width, int height, size_t src_stride,
+                   uint8_t* dst, size_t dst_stride);
+
+/**
+ * @brief bytes per pixel of layout.
+ */
+int grayPixelSize(GrayPixelLayout layout);
+
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __OPENCV_WECHAT_QRCODE_GRAY_CONVERT_HPP__
@@ -0,0 +1,43 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __OPENCV_WECHAT_QRCODE_IMAGE_VIEW_HPP__
+#define __OPENCV_WECHAT_QRCODE_IMAGE_VIEW_HPP__
+#include <cstddef>
+#include "simpleocv.h"
+namespace cv {
+namespace wechat_qrcode {
+
+/**
+ * @brief non-owning view of 8-bit gray pixels whose rows may be further apart than their width,
+ * such as a candidate region inside the full image. simpleocv Mats are always contiguous and
+ * their ROIs copy, so crops travel as views until a step has to produce new pixels anyway. The
+ * viewed pixels must outlive the view.
+ */
+struct ImageView {
+    const uchar* data = nullptr;
+    int cols = 0;
+    int rows = 0;
+    size_t step = 0;  // bytes from one row to the next
+
+    ImageView() {}
+    ImageView(const uchar* data_, int cols_, int rows_, size_t step_)
+        : data(data_), cols(cols_), rows(rows_), step(step_) {}
+    // a whole single channel Mat
+    ImageView(const Mat& img) : data(img.data), cols(img.cols), rows(img.rows), step((size_t)img.cols) {}
+
+    bool empty() const { return data == nullptr || cols <= 0 || rows <= 0; }
+    bool isContinuous() const { return step == (size_t)cols; }
+    const uchar* ptr(int y) const { return data + y * step; }
+
+    // the part of this view inside roi, which must lie within it
+    ImageView operator()(const Rect& roi) const { return ImageView(ptr(roi.y) + roi.x, roi.width, roi.height, step); }
+};
+
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __OPENCV_WECHAT_QRCODE_IMAGE_VIEW_HPP__
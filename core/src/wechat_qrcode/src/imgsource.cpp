@@ -19,15 +19,13 @@ namespace cv {
 namespace wechat_qrcode {
 
 // Initialize the ImgSource
-ImgSource::ImgSource(unsigned char* pixels, int width, int height)
+ImgSource::ImgSource(const unsigned char* pixels, int width, int height, int stride)
     : Super(width, height) {
-    luminances = new unsigned char[width * height];
-    memset(luminances, 0, width * height);
-
     rgbs = pixels;
 
     dataWidth = width;
     dataHeight = height;
+    dataStride = stride > 0 ? stride : width;
     left = 0;
     top = 0;
 
@@ -36,7 +34,7 @@ ImgSource::ImgSource(unsigned char* pixels, int width, int height)
 }
 
 // Added for crop function
-ImgSource::ImgSource(unsigned char* pixels, int width, int height, int left_, int top_,
+ImgSource::ImgSource(const unsigned char* pixels, int width, int height, int stride, int left_, int top_,
                      int cropWidth, int cropHeight,
                      ErrorHandler& err_handler)
     : Super(cropWidth, cropHeight) {
@@ -44,6 +42,7 @@ ImgSource::ImgSource(unsigned char* pixels, int width, int height, int left_, in
 
     dataWidth = width;
     dataHeight = height;
+    dataStride = stride > 0 ? stride : width;
     left = left_;
     top = top_;
 
@@ -55,29 +54,24 @@ ImgSource::ImgSource(unsigned char* pixels, int width, int height, int left_, in
         return;
     }
 
-    luminances = new unsigned char[width * height];
-
     // Make gray luminances first
     makeGray();
 }
 
-ImgSource::~ImgSource() {
-    if (luminances != NULL) {
-        delete[] luminances;
-    }
-}
+ImgSource::~ImgSource() {}
 
-Ref<ImgSource> ImgSource::create(unsigned char* pixels, int width, int height) {
-    return Ref<ImgSource>(new ImgSource(pixels, width, height));
+Ref<ImgSource> ImgSource::create(const unsigned char* pixels, int width, int height, int stride) {
+    return Ref<ImgSource>(new ImgSource(pixels, width, height, stride));
 }
 
-Ref<ImgSource> ImgSource::create(unsigned char* pixels, int width, int height, int left, int top,
+Ref<ImgSource> ImgSource::create(const unsigned char* pixels, int width, int height, int stride, int left, int top,
                                  int cropWidth, int cropHeight,
                                  zxing::ErrorHandler& err_handler) {
-    return Ref<ImgSource>(new ImgSource(pixels, width, height, left, top, cropWidth, cropHeight, err_handler));
+    return Ref<ImgSource>(
+        new ImgSource(pixels, width, height, stride, left, top, cropWidth, cropHeight, err_handler));
 }
 
-void ImgSource::reset(unsigned char* pixels, int width, int height) {
+void ImgSource::reset(const unsigned char* pixels, int width, int height) {
     rgbs = pixels;
     left = 0;
     top = 0;
@@ -86,6 +80,7 @@ void ImgSource::reset(unsigned char* pixels, int width, int height) {
     setHeight(height);
     dataWidth = width;
     dataHeight = height;
+    dataStride = width;
     makeGrayReset();
 }
 
@@ -100,10 +95,10 @@ ArrayRef<char> ImgSource::getRow(int y, zxing::ArrayRef<char> row,
     if (row->data() == NULL || row->empty() || row->size() < width) {
         row = zxing::ArrayRef<char>(width);
     }
-    int offset = (y + top) * dataWidth + left;
+    int offset = (y + top) * dataStride + left;
 
     char* rowPtr = &row[0];
-    arrayCopy(luminances, offset, rowPtr, 0, width);
+    arrayCopy(rgbs, offset, rowPtr, 0, width);
 
     return row;
 }
@@ -124,20 +119,20 @@ ArrayRef<char> ImgSource::getMatrix() const {
 
     zxing::ArrayRef<char> newMatrix = zxing::ArrayRef<char>(area);
 
-    int inputOffset = top * dataWidth + left;
+    int inputOffset = top * dataStride + left;
 
     // If the width matches the full width of the underlying data, perform a
     // single copy.
-    if (width == dataWidth) {
-        arrayCopy(luminances, inputOffset, &newMatrix[0], 0, area);
+    if (width == dataStride) {
+        arrayCopy(rgbs, inputOffset, &newMatrix[0], 0, area);
         return newMatrix;
     }
 
     // Otherwise copy one cropped row at a time.
     for (int y = 0; y < height; y++) {
         int outputOffset = y * width;
-        arrayCopy(luminances, inputOffset, &newMatrix[0], outputOffset, width);
-        inputOffset += dataWidth;
+        arrayCopy(rgbs, inputOffset, &newMatrix[0], outputOffset, width);
+        inputOffset += dataStride;
     }
     return newMatrix;
 }
@@ -145,16 +140,21 @@ ArrayRef<char> ImgSource::getMatrix() const {
 
 void ImgSource::makeGray() {
     int area = dataWidth * dataHeight;
+    if (dataStride == dataWidth) {
+        // packed rows are already the luminance matrix, so the binarizers read rgbs in place
+        _matrix = zxing::ArrayRef<char>(zxing::Array<char>::borrow(reinterpret_cast<const char*>(rgbs), area));
+        return;
+    }
+    // a view into a larger image, this gathers its rows and is the only copy the crop takes
     _matrix = zxing::ArrayRef<char>(area);
-    arrayCopy(rgbs, 0, &_matrix[0], 0, area);
+    for (int y = 0; y < dataHeight; y++) {
+        arrayCopy(rgbs, y * dataStride, &_matrix[0], y * dataWidth, dataWidth);
+    }
 }
 
-void ImgSource::makeGrayReset() {
-    int area = dataWidth * dataHeight;
-    arrayCopy(rgbs, 0, &_matrix[0], 0, area);
-}
+void ImgSource::makeGrayReset() { makeGray(); }
 
-void ImgSource::arrayCopy(unsigned char* src, int inputOffset, char* dst, int outputOffset,
+void ImgSource::arrayCopy(const unsigned char* src, int inputOffset, char* dst, int outputOffset,
                           int length) const {
     const unsigned char* srcPtr = src + inputOffset;
     char* dstPtr = dst + outputOffset;
@@ -166,7 +166,8 @@ bool ImgSource::isCropSupported() const { return true; }
 
 Ref<LuminanceSource> ImgSource::crop(int left_, int top_, int width, int height,
                                      ErrorHandler& err_handler) const {
-    return ImgSource::create(rgbs, dataWidth, dataHeight, left + left_, top + top_, width, height, err_handler);
+    return ImgSource::create(rgbs, dataWidth, dataHeight, dataStride, left + left_, top + top_, width, height,
+                             err_handler);
 }
 
 bool ImgSource::isRotateSupported() const { return false; }
@@ -177,7 +178,7 @@ Ref<LuminanceSource> ImgSource::rotateCounterClockwise(ErrorHandler& err_handler
     int width = getWidth();
     int height = getHeight();
 
-    return ImgSource::create(rgbs, dataWidth, dataHeight, top, left, height, width, err_handler);
+    return ImgSource::create(rgbs, dataWidth, dataHeight, dataStride, top, left, height, width, err_handler);
 }
 
 
@@ -18,31 +18,32 @@ namespace wechat_qrcode {
 class ImgSource : public zxing::LuminanceSource {
 private:
     typedef LuminanceSource Super;
-    zxing::ArrayRef<char> _matrix;
-    unsigned char* rgbs;
-    unsigned char* luminances;
+    zxing::ArrayRef<char> _matrix;  // borrows rgbs when its rows are packed, a copy of them otherwise
+    const unsigned char* rgbs;
     int dataWidth;
     int dataHeight;
+    int dataStride;  // bytes between rows of rgbs, at least dataWidth
     int left;
     int top;
     void makeGray();
     void makeGrayReset();
 
-    void arrayCopy(unsigned char* src, int inputOffset, char* dst, int outputOffset,
+    void arrayCopy(const unsigned char* src, int inputOffset, char* dst, int outputOffset,
                    int length) const;
 
 
     ~ImgSource();
 
 public:
-    ImgSource(unsigned char* pixels, int width, int height);
-    ImgSource(unsigned char* pixels, int width, int height, int left, int top, int cropWidth,
+    ImgSource(const unsigned char* pixels, int width, int height, int stride);
+    ImgSource(const unsigned char* pixels, int width, int height, int stride, int left, int top, int cropWidth,
               int cropHeight, zxing::ErrorHandler& err_handler);
 
-    static zxing::Ref<ImgSource> create(unsigned char* pixels, int width, int height);
-    static zxing::Ref<ImgSource> create(unsigned char* pixels, int width, int height, int left,
+    // stride 0 for rows packed at width
+    static zxing::Ref<ImgSource> create(const unsigned char* pixels, int width, int height, int stride = 0);
+    static zxing::Ref<ImgSource> create(const unsigned char* pixels, int width, int height, int stride, int left,
                                         int top, int cropWidth, int cropHeight, zxing::ErrorHandler& err_handler);
-    void reset(unsigned char* pixels, int width, int height);
+    void reset(const unsigned char* pixels, int width, int height);
     zxing::ArrayRef<char> getRow(int y, zxing::ArrayRef<char> row,
                                     zxing::ErrorHandler& err_handler) const override;
     zxing::ArrayRef<char> getMatrix() const override;
@@ -0,0 +1,29 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+#include "precomp.hpp"
+#include "model_store.hpp"
+#include <mutex>
+
+namespace cv {
+namespace wechat_qrcode {
+std::shared_ptr<const ncnn::Net> ModelStore::acquire(const std::string& name, Loader loader) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<const ncnn::Net>> models;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    auto& slot = models[name];
+    auto net = slot.lock();
+    if (!net) {
+        auto loaded = std::make_shared<ncnn::Net>();
+        loader(*loaded);
+        net = loaded;
+        slot = net;
+    }
+    return net;
+}
+}  // namespace wechat_qrcode
+}  // namespace cv
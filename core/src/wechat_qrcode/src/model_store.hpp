@@ -0,0 +1,35 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __OPENCV_WECHAT_QRCODE_MODEL_STORE_HPP__
+#define __OPENCV_WECHAT_QRCODE_MODEL_STORE_HPP__
+
+#include <memory>
+#include <string>
+#include "net.h"
+
+namespace cv {
+namespace wechat_qrcode {
+
+/**
+ * @brief Process-wide store of loaded ncnn models.
+ * All detector instances share the same read-only ncnn::Net for a given model, each inference
+ * creates its own ncnn::Extractor. A model is released when the last user drops it.
+ */
+class ModelStore {
+public:
+    typedef void (*Loader)(ncnn::Net& net);
+
+    /**
+     * @brief get the shared model of the given name, loading it with loader if needed.
+     */
+    static std::shared_ptr<const ncnn::Net> acquire(const std::string& name, Loader loader);
+};
+
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __OPENCV_WECHAT_QRCODE_MODEL_STORE_HPP__
@@ -0,0 +1,102 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#include "../precomp.hpp"
+#include "scale_ladder.hpp"
+
+namespace cv {
+namespace wechat_qrcode {
+// The finder and sampler are reliable from about two pixels per module, anything above that
+// only adds binarization cost.
+static const float kTargetModuleSize = 2.5f;
+static const float kStandardScales[] = {0.5f, 1.f, 2.f};
+
+// Appends the lengths of the inner runs along a line, thresholded halfway between its extremes.
+static void probeRuns(const uint8_t *p, int n, size_t step, vector<int> &runs) {
+    int lo = 255, hi = 0;
+    for (int i = 0; i < n; i++) {
+        lo = std::min(lo, (int)p[i * step]);
+        hi = std::max(hi, (int)p[i * step]);
+    }
+    if (hi - lo < 48) return;  // flat line, the code is not here
+    int threshold = (lo + hi) / 2;
+    bool dark = p[0] < threshold;
+    int start = -1;  // the first run is cut by the crop border and not counted
+    for (int i = 1; i < n; i++) {
+        bool cur_dark = p[i * step] < threshold;
+        if (cur_dark == dark) continue;
+        if (start >= 0) runs.push_back(i - start);
+        start = i;
+        dark = cur_dark;
+    }
+}
+
+float ScaleLadder::estimateModuleSize(const ImageView &img) {
+    if (img.empty()) return 0;
+    vector<int> runs;
+    for (int k = 1; k <= 3; k++) {
+        probeRuns(img.ptr(img.rows * k / 4), img.cols, 1, runs);
+        probeRuns(img.data + img.cols * k / 4, img.rows, img.step, runs);
+    }
+    if (runs.size() < 16) return 0;
+    // Runs span one or more modules, the lower quartile is close to a single module.
+    auto quartile = runs.begin() + runs.size() / 4;
+    std::nth_element(runs.begin(), quartile, runs.end());
+    return static_cast<float>(*quartile);
+}
+
+int ScaleLadder::moduleBin(float module_size) {
+    // below 1.5, 3, 6, 12 pixels and above
+    int bin = 0;
+    for (float edge = 1.5f; bin < MODULE_BIN_COUNT - 1 && module_size >= edge; edge *= 2) bin++;
+    return bin;
+}
+
+vector<float> ScaleLadder::order(float module_size, const vector<float> &scales, bool extend) {
+    if (!(module_size > 0)) return scales;
+    float ideal = kTargetModuleSize / module_size;
+
+    vector<float> ladder = scales;
+    if (extend) {
+        float nearest = kStandardScales[0];
+        for (float scale : kStandardScales) {
+            if (fabs(log2(scale / ideal)) < fabs(log2(nearest / ideal))) nearest = scale;
+        }
+        if (std::find(ladder.begin(), ladder.end(), nearest) == ladder.end()) ladder.push_back(nearest);
+    }
+
+    // Success rate seen for this module size, starting from a prior that falls off with the
+    // distance to the ideal scale so that the estimate decides until there is data.
+    int bin = moduleBin(module_size);
+    vector<std::pair<float, float>> scored;
+    {
+        std::lock_guard<std::mutex> g(mutex_);
+        for (float scale : ladder) {
+            auto it = entries_[bin].find(scale);
+            const Entry entry = it != entries_[bin].end() ? it->second : Entry();
+            float prior = exp(-fabs(log2(scale / ideal)));
+            scored.emplace_back((entry.successes + 2.f * prior) / (entry.attempts + 2.f), scale);
+        }
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<float, float> &a, const std::pair<float, float> &b) {
+                         return a.first > b.first;
+                     });
+    for (size_t i = 0; i < scored.size(); i++) ladder[i] = scored[i].second;
+    return ladder;
+}
+
+void ScaleLadder::record(float module_size, float scale, bool success) {
+    if (!(module_size > 0)) return;
+    std::lock_guard<std::mutex> g(mutex_);
+    Entry &entry = entries_[moduleBin(module_size)][scale];
+    entry.attempts++;
+    if (success) entry.successes++;
+}
+
+}  // namespace wechat_qrcode
+}  // namespace cv
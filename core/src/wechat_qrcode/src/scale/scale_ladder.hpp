@@ -0,0 +1,59 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __SCALE_SCALE_LADDER_HPP_
+#define __SCALE_SCALE_LADDER_HPP_
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include "../image_view.hpp"
+#include "simpleocv.h"
+namespace cv {
+namespace wechat_qrcode {
+
+/**
+ * @brief Orders the scales tried on a candidate by the estimated module size of the code, refined
+ * by which scales actually succeeded for similar module sizes on this detector. Thread safe.
+ */
+class ScaleLadder {
+public:
+    /**
+     * @brief module size in pixels estimated from the run lengths along a few rows and columns
+     * through the middle of a grayscale crop, 0 when there is too little contrast to tell.
+     */
+    static float estimateModuleSize(const ImageView &img);
+
+    /**
+     * @brief scales ordered by predicted success for the module size. With extend, the standard
+     * scale closest to the ideal one is added when scales lacks it, which is only meant for the
+     * default ladder: scales the caller configured are never added to. A module size of 0 keeps
+     * the given order.
+     */
+    std::vector<float> order(float module_size, const std::vector<float> &scales, bool extend);
+
+    /**
+     * @brief record the outcome of a scale attempt. Attempts cut short must not be recorded.
+     */
+    void record(float module_size, float scale, bool success);
+
+private:
+    enum { MODULE_BIN_COUNT = 5 };
+    static int moduleBin(float module_size);
+
+    struct Entry {
+        int attempts = 0;
+        int successes = 0;
+    };
+    std::mutex mutex_;
+    // by scale, each scale counted on its own
+    std::map<float, Entry> entries_[MODULE_BIN_COUNT];
+};
+
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __SCALE_SCALE_LADDER_HPP_
@@ -6,6 +6,7 @@
 // Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
 #include "../precomp.hpp"
 #include "super_scale.hpp"
+#include "../model_store.hpp"
 #ifdef SR_USE_OPT_MODEL
 #include "sr_opt.id.h"
 #include "sr_opt.mem.h"
@@ -16,53 +17,65 @@
 
 namespace cv {
 namespace wechat_qrcode {
-int SuperScale::init() {
-    srnet_.opt.num_threads = 1;
-    srnet_.load_param(sr_param_bin);
-    srnet_.load_model(sr_bin);
+static void loadSrModel(ncnn::Net& net) {
+    net.opt.num_threads = 1;
+    net.load_param(sr_param_bin);
+    net.load_model(sr_bin);
+}
+
+int SuperScale::init(int num_threads) {
+    srnet_ = ModelStore::acquire("sr", loadSrModel);
+    num_threads_ = num_threads;
     net_loaded_ = true;
     return 0;
 }
 
-Mat SuperScale::processImageScale(const Mat &src, float scale, const bool &use_sr,
-                                  int sr_max_size) {
-    Mat dst = src;
+ImageView SuperScale::processImageScale(const ImageView &src, float scale, const bool &use_sr, Mat &dst,
+                                        int sr_max_size, bool *sr_applied) {
+    if (sr_applied) *sr_applied = false;
     if (scale == 1.0) {  // src
-        return dst;
+        return src;
     }
 
     int width = src.cols;
     int height = src.rows;
     int target_width = width * scale;
     int target_height = height * scale;
-    if (scale == 2.0) {  // upsample
+    if (scale > 1.0) {  // upsample, the super resolution model only does 2x
         int SR_TH = sr_max_size;
-        if (use_sr && (int)sqrt(width * height * 1.0) < SR_TH && net_loaded_) {
+        if (scale == 2.0 && use_sr && (int)sqrt(width * height * 1.0) < SR_TH && net_loaded_) {
             int ret = superResoutionScale(src, dst);
-            if (ret == 0) return dst;
+            if (ret == 0) {
+                if (sr_applied) *sr_applied = true;
+                return ImageView(dst);
+            }
         }
 
         {
             dst.create(target_height, target_width, CV_8UC1);
-            ncnn::Mat ncnn_src = ncnn::Mat::from_pixels(src.data, ncnn::Mat::PIXEL_GRAY, src.cols, src.rows);
+            ncnn::Mat ncnn_src = ncnn::Mat::from_pixels(src.data, ncnn::Mat::PIXEL_GRAY, src.cols, src.rows,
+                                                        static_cast<int>(src.step));
             ncnn::Mat ncnn_dst;
             ncnn::resize_bicubic(ncnn_src, ncnn_dst, target_width, target_height);
             ncnn_dst.to_pixels(dst.data, ncnn::Mat::PIXEL_GRAY);
         }
     } else if (scale < 1.0) {  // downsample
         dst.create(target_height, target_width, CV_8UC1);
-        ncnn::resize_bilinear_c1(src.data, width, height, dst.data, target_width, target_height);
+        ncnn::resize_bilinear_c1(src.data, width, height, static_cast<int>(src.step), dst.data, target_width,
+                                 target_height, target_width);
     }
 
-    return dst;
+    return ImageView(dst);
 }
 
-int SuperScale::superResoutionScale(const Mat &src, Mat &dst) {
-    ncnn::Mat blob = ncnn::Mat::from_pixels(src.data, ncnn::Mat::PIXEL_GRAY, src.cols, src.rows);
+int SuperScale::superResoutionScale(const ImageView &src, Mat &dst) {
+    ncnn::Mat blob = ncnn::Mat::from_pixels(src.data, ncnn::Mat::PIXEL_GRAY, src.cols, src.rows,
+                                            static_cast<int>(src.step));
     const float norm_vals[] = { 1.f / 255.f };
     blob.substract_mean_normalize(nullptr, norm_vals);
 
-    ncnn::Extractor ex = srnet_.create_extractor();
+    ncnn::Extractor ex = srnet_->create_extractor();
+    ex.set_num_threads(num_threads_);
     ex.input(sr_param_id::BLOB_data, blob);
 
     ncnn::Mat prob;
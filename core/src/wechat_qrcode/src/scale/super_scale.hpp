@@ -9,6 +9,8 @@
 #define __SCALE_SUPER_SCALE_HPP_
 
 #include <stdio.h>
+#include <memory>
+#include "../image_view.hpp"
 #include "net.h"
 #include "simpleocv.h"
 namespace cv {
@@ -18,13 +20,20 @@ class SuperScale {
 public:
     SuperScale(){};
     ~SuperScale(){};
-    int init();
-    Mat processImageScale(const Mat &src, float scale, const bool &use_sr, int sr_max_size = 160);
+    int init(int num_threads = 1);
+    /**
+     * @brief src resized by scale. At scale 1 that is src itself without touching a pixel,
+     * otherwise the view points into buffer.
+     */
+    ImageView processImageScale(const ImageView &src, float scale, const bool &use_sr, Mat &buffer,
+                                int sr_max_size = 160, bool *sr_applied = nullptr);
 
 private:
-    ncnn::Net srnet_;
+    // shared by all detector instances, see ModelStore
+    std::shared_ptr<const ncnn::Net> srnet_;
+    int num_threads_ = 1;
     bool net_loaded_ = false;
-    int superResoutionScale(const cv::Mat &src, cv::Mat &dst);
+    int superResoutionScale(const ImageView &src, cv::Mat &dst);
 };
 
 }  // namespace wechat_qrcode
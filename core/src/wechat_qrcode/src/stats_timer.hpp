@@ -0,0 +1,40 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __OPENCV_WECHAT_QRCODE_STATS_TIMER_HPP__
+#define __OPENCV_WECHAT_QRCODE_STATS_TIMER_HPP__
+#include <chrono>
+namespace cv {
+namespace wechat_qrcode {
+/**
+ * @brief Stopwatch for DecodeStats. A disabled timer never reads the clock and always reports 0,
+ * so stages can be timed unconditionally at no cost when stats are off.
+ */
+class StatsTimer {
+public:
+    explicit StatsTimer(bool enabled) : enabled_(enabled) {
+        if (enabled_) start_ = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @brief milliseconds since construction or the previous lap, then restart.
+     */
+    double lap() {
+        if (!enabled_) return 0;
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - start_).count();
+        start_ = now;
+        return ms;
+    }
+
+private:
+    bool enabled_;
+    std::chrono::steady_clock::time_point start_;
+};
+}  // namespace wechat_qrcode
+}  // namespace cv
+#endif  // __OPENCV_WECHAT_QRCODE_STATS_TIMER_HPP__
@@ -9,10 +9,22 @@
 #include "decodermgr.hpp"
 #include "detector/align.hpp"
 #include "detector/ssd_detector.hpp"
+#include "gray_convert.hpp"
+#include "scale/scale_ladder.hpp"
 #include "scale/super_scale.hpp"
+#include "stats_timer.hpp"
 #include "zxing/result.hpp"
 namespace cv {
 namespace wechat_qrcode {
+// Codes decoded from one candidate. Kept apart until every candidate is done so that the merged
+// output does not depend on which thread finished first.
+struct CandidateResult {
+    vector<string> texts;
+    vector<vector<Point2f>> points;  // input image coordinates
+    vector<vector<uint8_t>> raw_bytes;
+    DecodeStats stats;
+};
+
 class WeChatQRCode::Impl {
 public:
     Impl() {}
@@ -20,39 +32,107 @@ public:
     /**
      * @brief detect QR codes from the given image
      *
-     * @param img supports grayscale or color (BGR) image.
+     * @param img gray image.
      * @return vector<Mat> detected QR code bounding boxes.
      */
-    std::vector<Mat> detect(const Mat& img);
+    std::vector<Mat> detect(const ImageView& img, SSDDetector::Session* session = nullptr);
     /**
      * @brief decode QR codes from detected points
+     * Candidates are decoded through parallel_for_ when it is set, the results are merged in
+     * candidate order.
      *
-     * @param img supports grayscale or color (BGR) image.
+     * @param img gray image.
      * @param candidate_points detected points. we name it "candidate points" which means no
      * all the qrcode can be decoded.
      * @param points succussfully decoded qrcode with bounding box points.
+     * @param raw_bytes raw data codewords of each successfully decoded qrcode.
+     * @param stats optional per-call stats, see DecodeStats.
+     * @param crop_candidates crop each candidate region, otherwise the whole image is decoded once.
+     * @param control optional time budget and cancellation, checked before every scale attempt.
      * @return vector<string>
      */
-    std::vector<std::string> decode(const Mat& img,
+    std::vector<std::string> decode(const ImageView& img,
                                     const std::vector<Mat>& candidate_points,
-                                    std::vector<Mat>& points);
-    int applyDetector(const Mat& img, std::vector<Mat>& points);
-    Mat cropObj(const Mat& img, const Mat& point, Align& aligner);
+                                    std::vector<Mat>& points,
+                                    std::vector<std::vector<uint8_t>>& raw_bytes,
+                                    DecodeStats* stats,
+                                    bool crop_candidates,
+                                    DecodeControl* control);
+    /**
+     * @brief crop, scale and decode a single candidate, trying the scales until one succeeds.
+     */
+    void decodeCandidate(const ImageView& img, const Mat& point, bool crop_candidate, bool collect_stats,
+                         DecodeControl* control, CandidateResult& result);
+    /**
+     * @brief apply the binarizer configuration of this detector to a decoder.
+     */
+    void configureDecoder(DecoderMgr& decodemgr);
+    /**
+     * @brief a configured decoder for the calling thread to use alone, returned to the pool of
+     * this detector when the pointer is released. Pooled decoders keep their reader and
+     * UnicomBlock buffers, so decoding reuses them across scales and calls.
+     */
+    std::shared_ptr<DecoderMgr> acquireDecoder();
+    /**
+     * @brief decode a cropped candidate at one scale, appending to result on success.
+     * @return 0 when at least one code was decoded.
+     */
+    int decodeScale(const ImageView& cropped_img, float scale, DecoderMgr& decodemgr, bool collect_stats,
+                    DecodeControl* control, CandidateResult& result);
+    /**
+     * @brief candidate regions around the codes tracked in a stream, expanded by state.roi_expand.
+     */
+    std::vector<Mat> trackedCandidates(const StreamState& state, int width, int height);
+    int applyDetector(const ImageView& img, std::vector<Mat>& points, SSDDetector::Session* session);
+    ImageView cropObj(const ImageView& img, const Mat& point, Align& aligner, Mat& rotated);
     std::vector<float> getScaleList(const int width, const int height);
     std::shared_ptr<SSDDetector> detector_;
     std::shared_ptr<SuperScale> super_resolution_model_;
     bool use_nn_detector_, use_nn_sr_;
     float scaleFactor = -1.f;
+    float detector_target_area_ = 400.f * 400.f;
+    std::vector<BinarizerMgr::BINARIZER> binarizers_;
+    std::vector<float> scales_;
+    std::function<void(int, const std::function<void(int)>&)> parallel_for_;
+    bool speculative_scales_ = false;
+    bool parallel_binarizers_ = false;
+    std::shared_ptr<BinarizerStats> binarizer_stats_;
+    std::shared_ptr<ScaleLadder> scale_ladder_;
+    int max_results_ = 0;
+    // idle decoders, as many as have been in use at the same time
+    std::mutex decoder_pool_mutex_;
+    std::vector<std::unique_ptr<DecoderMgr>> decoder_pool_;
 };
 
-WeChatQRCode::WeChatQRCode() {
+struct DecodeScratch::Buffers {
+    SSDDetector::Session detector;
+};
+
+DecodeScratch::DecodeScratch() : buffers_(std::make_unique<Buffers>()) {}
+
+DecodeScratch::~DecodeScratch() {}
+
+WeChatQRCode::WeChatQRCode() : WeChatQRCode(Options()) {}
+
+WeChatQRCode::WeChatQRCode(const Options& options) {
     p = make_shared<WeChatQRCode::Impl>();
+    p->detector_target_area_ = options.detector_target_area;
+    for (int binarizer : options.binarizers) {
+        p->binarizers_.push_back(static_cast<BinarizerMgr::BINARIZER>(binarizer));
+    }
+    p->scales_ = options.scales;
+    p->parallel_for_ = options.parallel_for;
+    p->speculative_scales_ = options.speculative_scales;
+    p->parallel_binarizers_ = options.parallel_binarizers;
+    if (options.adaptive_binarizers) p->binarizer_stats_ = make_shared<BinarizerStats>();
+    if (options.adaptive_scales) p->scale_ladder_ = make_shared<ScaleLadder>();
+    p->max_results_ = std::max(options.max_results, 0);
 
     // initialize detector model (caffe)
-    {
-        p->use_nn_detector_ = true;
+    p->use_nn_detector_ = options.use_nn_detector;
+    if (p->use_nn_detector_) {
         p->detector_ = make_shared<SSDDetector>();
-        auto ret = p->detector_->init();
+        auto ret = p->detector_->init(options.num_threads);
     }
 
     // initialize super_resolution_model
@@ -60,29 +140,62 @@ WeChatQRCode::WeChatQRCode() {
     // so, we initialize it first.
     {
         p->super_resolution_model_ = make_shared<SuperScale>();
-        p->use_nn_sr_ = true;
+        p->use_nn_sr_ = options.use_nn_sr;
         // initialize dnn model (caffe format)
-        auto ret = p->super_resolution_model_->init();
+        if (p->use_nn_sr_) {
+            auto ret = p->super_resolution_model_->init(options.num_threads);
+        }
     }
 }
 
+static Mat toGray(const Mat& img) {
+    int incn = img.channels();
+    if (incn == 3 || incn == 4) {
+        Mat gray;
+        gray.create(img.rows, img.cols, CV_8UC1);
+        convertToGray(img.data, incn == 3 ? GRAY_FROM_BGR : GRAY_FROM_BGRA, img.cols, img.rows,
+                      (size_t)img.cols * incn, gray.data, img.cols);
+        return gray;
+    }
+    return img;
+}
+
 vector<string> WeChatQRCode::detectAndDecode(cv::Mat &img, std::vector<cv::Mat> &points) {
-    if (img.cols <= 20 || img.rows <= 20) {
+    vector<vector<uint8_t>> raw_bytes;
+    return detectAndDecode(img, points, raw_bytes);
+}
+
+vector<string> WeChatQRCode::detectAndDecode(cv::Mat &img, std::vector<cv::Mat> &points,
+                                             std::vector<std::vector<uint8_t>> &raw_bytes,
+                                             DecodeStats *stats, DecodeControl *control, DecodeScratch *scratch) {
+    Mat gray = toGray(img);
+    return detectAndDecode(gray.data, gray.cols, gray.rows, (size_t)gray.cols, points, raw_bytes, stats, control,
+                           scratch);
+}
+
+vector<string> WeChatQRCode::detectAndDecode(const uchar *gray, int width, int height, size_t step,
+                                             std::vector<cv::Mat> &points,
+                                             std::vector<std::vector<uint8_t>> &raw_bytes,
+                                             DecodeStats *stats, DecodeControl *control, DecodeScratch *scratch) {
+    raw_bytes.clear();
+    StatsTimer total_timer(stats != nullptr);
+    if (stats) stats->calls++;
+    if (width <= 20 || height <= 20) {
         return vector<string>();  // image data is not enough for providing reliable results
     }
-    Mat input_img;
-    int incn = img.channels();
-    if (incn == 3 || incn == 4) {
-        int type = incn == 3 ? ncnn::Mat::PIXEL_BGR2GRAY : ncnn::Mat::PIXEL_BGRA2GRAY;
-        ncnn::Mat ncnn_img = ncnn::Mat::from_pixels(img.data, type, img.cols, img.rows);
-        input_img.create(img.rows, img.cols, CV_8UC1);
-        ncnn_img.to_pixels(input_img.data, ncnn::Mat::PIXEL_GRAY);
-    } else {
-        input_img = img;
+    if (control && control->shouldStop()) {
+        points.clear();
+        return vector<string>();
+    }
+    ImageView input_img(gray, width, height, step);
+    StatsTimer detect_timer(stats != nullptr);
+    auto candidate_points = p->detect(input_img, scratch ? &scratch->buffers_->detector : nullptr);
+    if (stats) {
+        stats->detect_ms += detect_timer.lap();
+        stats->candidates += static_cast<int>(candidate_points.size());
     }
-    auto candidate_points = p->detect(input_img);
     auto res_points = vector<Mat>();
-    auto ret = p->decode(input_img, candidate_points, res_points);
+    auto ret = p->decode(input_img, candidate_points, res_points, raw_bytes, stats, p->use_nn_detector_, control);
     // opencv type convert
     vector<Mat> tmp_points;
     for (size_t i = 0; i < res_points.size(); i++) {
@@ -90,9 +203,136 @@ vector<string> WeChatQRCode::detectAndDecode(cv::Mat &img, std::vector<cv::Mat>
         tmp_points.push_back(tmp_point);
     }
     points = tmp_points;
+    if (stats) {
+        stats->codes += static_cast<int>(ret.size());
+        if (!ret.empty()) stats->successful_calls++;
+        stats->total_ms += total_timer.lap();
+    }
     return ret;
 }
 
+vector<string> WeChatQRCode::detectAndDecodeStream(cv::Mat &img, StreamState &state, std::vector<cv::Mat> &points,
+                                                   std::vector<std::vector<uint8_t>> &raw_bytes,
+                                                   DecodeStats *stats, DecodeControl *control) {
+    Mat gray = toGray(img);
+    return detectAndDecodeStream(gray.data, gray.cols, gray.rows, (size_t)gray.cols, state, points, raw_bytes, stats,
+                                 control);
+}
+
+vector<string> WeChatQRCode::detectAndDecodeStream(const uchar *gray, int width, int height, size_t step,
+                                                   StreamState &state, std::vector<cv::Mat> &points,
+                                                   std::vector<std::vector<uint8_t>> &raw_bytes,
+                                                   DecodeStats *stats, DecodeControl *control) {
+    bool refresh = state.tracked_points.empty() ||
+                   (state.refresh_interval > 0 && state.frames_since_refresh + 1 >= state.refresh_interval);
+    if (!refresh && width > 20 && height > 20) {
+        StatsTimer total_timer(stats != nullptr);
+        ImageView input_img(gray, width, height, step);
+        auto candidate_points = p->trackedCandidates(state, input_img.cols, input_img.rows);
+        vector<Mat> res_points;
+        vector<vector<uint8_t>> res_raw_bytes;
+        DecodeStats tracked_stats;
+        auto ret = p->decode(input_img, candidate_points, res_points, res_raw_bytes,
+                             stats ? &tracked_stats : nullptr, true, control);
+        if (stats) {
+            tracked_stats.candidates += static_cast<int>(candidate_points.size());
+            tracked_stats.total_ms += total_timer.lap();
+            *stats += tracked_stats;
+        }
+        // Out of time: hand back what the tracked regions gave and keep tracking the old codes.
+        if (control && control->status() != DecodeControl::RUNNING) {
+            if (stats) {
+                stats->calls++;
+                stats->codes += static_cast<int>(ret.size());
+                if (!ret.empty()) stats->successful_calls++;
+            }
+            points = res_points;
+            raw_bytes = std::move(res_raw_bytes);
+            return ret;
+        }
+        // Every tracked code was found again, or as many as max_results asks for, this frame is done.
+        size_t expected = state.tracked_points.size();
+        if (p->max_results_ > 0) expected = std::min(expected, static_cast<size_t>(p->max_results_));
+        if (ret.size() >= expected) {
+            if (stats) {
+                stats->calls++;
+                stats->successful_calls++;
+                stats->tracked_calls++;
+                stats->codes += static_cast<int>(ret.size());
+            }
+            state.tracked_points = res_points;
+            state.frames_since_refresh++;
+            points = res_points;
+            raw_bytes = std::move(res_raw_bytes);
+            return ret;
+        }
+    }
+
+    // Tracking lost, nothing tracked yet or time for a refresh: run the full pipeline.
+    auto ret = detectAndDecode(gray, width, height, step, points, raw_bytes, stats, control);
+    if (!control || control->status() == DecodeControl::RUNNING) {
+        state.tracked_points = points;
+        state.frames_since_refresh = 0;
+    }
+    return ret;
+}
+
+DecodeControl::DecodeControl(int timeout_ms, const std::atomic<bool>* cancel) : cancel_(cancel) {
+    if (timeout_ms >= 0) {
+        deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+}
+
+void DecodeControl::setParent(DecodeControl* parent) { parent_ = parent; }
+
+bool DecodeControl::shouldStop() {
+    if (status_.load(std::memory_order_relaxed) != RUNNING) {
+        return true;
+    }
+    if (parent_ && parent_->shouldStop()) {
+        status_.store(parent_->status(), std::memory_order_relaxed);
+        return true;
+    }
+    if (cancel_ && cancel_->load(std::memory_order_relaxed)) {
+        status_.store(CANCELLED, std::memory_order_relaxed);
+        return true;
+    }
+    if (deadline_ != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline_) {
+        status_.store(TIMED_OUT, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+DecodeStats& DecodeStats::operator+=(const DecodeStats& other) {
+    calls += other.calls;
+    successful_calls += other.successful_calls;
+    codes += other.codes;
+    candidates += other.candidates;
+    scale_attempts += other.scale_attempts;
+    tracked_calls += other.tracked_calls;
+    for (int i = 0; i < BINARIZER_COUNT; i++) {
+        binarizer_attempts[i] += other.binarizer_attempts[i];
+        binarizer_successes[i] += other.binarizer_successes[i];
+        binarizer_ms[i] += other.binarizer_ms[i];
+    }
+    total_ms += other.total_ms;
+    detect_ms += other.detect_ms;
+    crop_scale_ms += other.crop_scale_ms;
+    sr_ms += other.sr_ms;
+    finder_ms += other.finder_ms;
+    decoder_ms += other.decoder_ms;
+    return *this;
+}
+
+std::string WeChatQRCode::saveBinarizerStats() {
+    return p->binarizer_stats_ ? p->binarizer_stats_->save() : std::string();
+}
+
+bool WeChatQRCode::loadBinarizerStats(const std::string& text) {
+    return p->binarizer_stats_ && p->binarizer_stats_->load(text);
+}
+
 void WeChatQRCode::setScaleFactor(float _scaleFactor) {
     if (_scaleFactor > 0 && _scaleFactor <= 1.f)
         p->scaleFactor = _scaleFactor;
@@ -104,84 +344,257 @@ float WeChatQRCode::getScaleFactor() {
     return p->scaleFactor;
 };
 
-vector<string> WeChatQRCode::Impl::decode(const Mat& img,
+vector<string> WeChatQRCode::Impl::decode(const ImageView& img,
                                           const vector<Mat>& candidate_points,
-                                          vector<Mat>& points) {
+                                          vector<Mat>& points,
+                                          vector<vector<uint8_t>>& raw_bytes,
+                                          DecodeStats* stats,
+                                          bool crop_candidates,
+                                          DecodeControl* control) {
     if (candidate_points.size() == 0) {
         return vector<string>();
     }
+    int candidate_count = static_cast<int>(candidate_points.size());
+    vector<CandidateResult> candidates(candidate_count);
     vector<string> decode_results;
-    for (const auto& point : candidate_points) {
-        Mat cropped_img;
-        Align aligner;
-        if (use_nn_detector_) {
-            cropped_img = cropObj(img, point, aligner);
-        } else {
-            cropped_img = img;
-        }
-        // scale_list contains different scale ratios
-        auto scale_list = getScaleList(cropped_img.cols, cropped_img.rows);
-        for (auto cur_scale : scale_list) {
-            Mat scaled_img =
-                super_resolution_model_->processImageScale(cropped_img, cur_scale, use_nn_sr_);
-            string result;
-            DecoderMgr decodemgr;
-            vector<vector<Point2f>> zxing_points, check_points;
-            auto ret = decodemgr.decodeImage(scaled_img, use_nn_detector_, decode_results, zxing_points);
-            if (ret == 0) {
-                for(size_t i = 0; i <zxing_points.size(); i++){
-                    vector<Point2f> points_qr = zxing_points[i];
-                    for (auto&& pt: points_qr) {
-                        pt.x /= cur_scale;
-                        pt.y /= cur_scale;
-                    }
-
-                    if (use_nn_detector_)
-                        points_qr = aligner.warpBack(points_qr);
-
-                    int num_points = static_cast<int>(points_qr.size());
-                    auto point_to_save = Mat(num_points, 2, CV_32FC1);
-                    for (int j = 0; j < num_points; ++j) {
-                        point_to_save.ptr<float>(j)[0] = points_qr[j].x;
-                        point_to_save.ptr<float>(j)[1] = points_qr[j].y;
-                    }
-                    // try to find duplicate qr corners
-                    bool isDuplicate = false;
-                    for (const auto &tmp_points: check_points) {
-                        const float eps = 10.f;
-                        for (size_t j = 0; j < tmp_points.size(); j++) {
-                            if (abs(tmp_points[j].x - points_qr[j].x) < eps &&
-                                abs(tmp_points[j].y - points_qr[j].y) < eps) {
-                                isDuplicate = true;
-                            }
-                            else {
-                                isDuplicate = false;
-                                break;
-                            }
-                        }
-                    }
-                    if (isDuplicate == false) {
-                        points.push_back(point_to_save);
-                        check_points.push_back(points_qr);
+    auto merge = [&](CandidateResult& candidate) {
+        if (stats) *stats += candidate.stats;
+        // Duplicates are decided within the candidate, and only the codes kept append their text,
+        // raw bytes and points, so the three stay in step across candidates.
+        vector<vector<Point2f>> check_points;
+        for (size_t i = 0; i < candidate.points.size(); i++) {
+            const vector<Point2f>& points_qr = candidate.points[i];
+            int num_points = static_cast<int>(points_qr.size());
+            auto point_to_save = Mat(num_points, 2, CV_32FC1);
+            for (int j = 0; j < num_points; ++j) {
+                point_to_save.ptr<float>(j)[0] = points_qr[j].x;
+                point_to_save.ptr<float>(j)[1] = points_qr[j].y;
+            }
+            // try to find duplicate qr corners
+            bool isDuplicate = false;
+            for (const auto &tmp_points: check_points) {
+                const float eps = 10.f;
+                for (size_t j = 0; j < tmp_points.size(); j++) {
+                    if (abs(tmp_points[j].x - points_qr[j].x) < eps &&
+                        abs(tmp_points[j].y - points_qr[j].y) < eps) {
+                        isDuplicate = true;
                     }
                     else {
-                        decode_results.erase(decode_results.begin() + i, decode_results.begin() + i + 1);
+                        isDuplicate = false;
+                        break;
                     }
                 }
-                break;
             }
+            if (isDuplicate == false) {
+                points.push_back(point_to_save);
+                check_points.push_back(points_qr);
+                decode_results.push_back(std::move(candidate.texts[i]));
+                raw_bytes.push_back(std::move(candidate.raw_bytes[i]));
+            }
+        }
+    };
+
+    // With max_results the remaining candidates, scales and binarizers are cut short through this
+    // control once enough codes are in. The caller's own control still applies through the parent.
+    std::atomic<bool> enough{false};
+    DecodeControl limit_control(-1, &enough);
+    limit_control.setParent(control);
+    DecodeControl* candidate_control = max_results_ > 0 ? &limit_control : control;
+    if (parallel_for_ && candidate_count > 1) {
+        // Duplicates are only known after the ordered merge, so stop on the raw count. Which codes
+        // are returned may then depend on thread timing when there are more than max_results.
+        std::atomic<int> decoded{0};
+        parallel_for_(candidate_count, [&](int i) {
+            decodeCandidate(img, candidate_points[i], crop_candidates, stats != nullptr, candidate_control,
+                            candidates[i]);
+            int count = static_cast<int>(candidates[i].texts.size());
+            if (max_results_ > 0 && count > 0 && decoded.fetch_add(count) + count >= max_results_) {
+                enough.store(true);
+            }
+        });
+        for (auto& candidate : candidates) merge(candidate);
+    } else {
+        for (int i = 0; i < candidate_count; i++) {
+            decodeCandidate(img, candidate_points[i], crop_candidates, stats != nullptr, candidate_control,
+                            candidates[i]);
+            merge(candidates[i]);
+            if (max_results_ > 0 && static_cast<int>(decode_results.size()) >= max_results_) break;
         }
     }
+    if (max_results_ > 0 && static_cast<int>(decode_results.size()) > max_results_) {
+        decode_results.resize(max_results_);
+        raw_bytes.resize(max_results_);
+        points.resize(max_results_);
+    }
 
     return decode_results;
 }
 
-vector<Mat> WeChatQRCode::Impl::detect(const Mat& img) {
+void WeChatQRCode::Impl::decodeCandidate(const ImageView& img, const Mat& point, bool crop_candidate, bool collect_stats,
+                                         DecodeControl* control, CandidateResult& result) {
+    if (control && control->shouldStop()) return;
+    DecodeStats* stats = collect_stats ? &result.stats : nullptr;
+    StatsTimer timer(collect_stats);
+    // a view into img, so cropping copies nothing until a scale or the decoder needs the pixels
+    ImageView cropped_img;
+    Mat rotated;
+    Align aligner;
+    if (crop_candidate) {
+        cropped_img = cropObj(img, point, aligner, rotated);
+    } else {
+        cropped_img = img;
+    }
+    if (stats) stats->crop_scale_ms += timer.lap();
+
+    // scale_list contains different scale ratios
+    auto scale_list = getScaleList(cropped_img.cols, cropped_img.rows);
+    float module_size = 0;
+    if (scale_ladder_) {
+        module_size = ScaleLadder::estimateModuleSize(cropped_img);
+        scale_list = scale_ladder_->order(module_size, scale_list, scales_.empty());
+    }
+    int scale_count = static_cast<int>(scale_list.size());
+    if (speculative_scales_ && parallel_for_ && scale_count > 1) {
+        // Try every scale at once. A success cancels the attempts at later scales, earlier ones keep
+        // running, so the scale that wins is the one the serial ladder would have picked.
+        vector<CandidateResult> attempts(scale_count);
+        vector<std::atomic<bool>> cancelled(scale_count);
+        for (auto& flag : cancelled) flag.store(false);
+        parallel_for_(scale_count, [&](int i) {
+            DecodeControl attempt_control(-1, &cancelled[i]);
+            attempt_control.setParent(control);
+            auto decodemgr = acquireDecoder();
+            int ret =
+                decodeScale(cropped_img, scale_list[i], *decodemgr, collect_stats, &attempt_control, attempts[i]);
+            if (ret == 0) {
+                for (int j = i + 1; j < scale_count; j++) cancelled[j].store(true);
+            }
+            if (scale_ladder_ && attempt_control.status() == DecodeControl::RUNNING) {
+                scale_ladder_->record(module_size, scale_list[i], ret == 0);
+            }
+        });
+        bool found = false;
+        for (auto& attempt : attempts) {
+            if (stats) *stats += attempt.stats;
+            if (!found && !attempt.texts.empty()) {
+                result.texts = std::move(attempt.texts);
+                result.points = std::move(attempt.points);
+                result.raw_bytes = std::move(attempt.raw_bytes);
+                found = true;
+            }
+        }
+    } else {
+        // one decoder serves every scale of this candidate, it is private to the thread running it
+        auto decodemgr = acquireDecoder();
+        for (auto cur_scale : scale_list) {
+            if (control && control->shouldStop()) break;
+            int ret = decodeScale(cropped_img, cur_scale, *decodemgr, collect_stats, control, result);
+            if (scale_ladder_ && (!control || control->status() == DecodeControl::RUNNING)) {
+                scale_ladder_->record(module_size, cur_scale, ret == 0);
+            }
+            if (ret == 0) break;
+        }
+    }
+    if (crop_candidate) {
+        for (auto& points_qr : result.points) points_qr = aligner.warpBack(points_qr);
+    }
+}
+
+void WeChatQRCode::Impl::configureDecoder(DecoderMgr& decodemgr) {
+    if (!binarizers_.empty()) decodemgr.setBinarizers(binarizers_);
+    if (parallel_binarizers_) decodemgr.setParallelFor(parallel_for_);
+    decodemgr.setBinarizerStats(binarizer_stats_.get());
+    decodemgr.setMaxResults(max_results_);
+}
+
+std::shared_ptr<DecoderMgr> WeChatQRCode::Impl::acquireDecoder() {
+    std::unique_ptr<DecoderMgr> decodemgr;
+    {
+        std::lock_guard<std::mutex> lock(decoder_pool_mutex_);
+        if (!decoder_pool_.empty()) {
+            decodemgr = std::move(decoder_pool_.back());
+            decoder_pool_.pop_back();
+        }
+    }
+    if (!decodemgr) {
+        decodemgr.reset(new DecoderMgr());
+        configureDecoder(*decodemgr);
+    }
+    // the detector outlives every call decoding with it, and so every decoder it lends out
+    return std::shared_ptr<DecoderMgr>(decodemgr.release(), [this](DecoderMgr* released) {
+        std::lock_guard<std::mutex> lock(decoder_pool_mutex_);
+        decoder_pool_.emplace_back(released);
+    });
+}
+
+int WeChatQRCode::Impl::decodeScale(const ImageView& cropped_img, float scale, DecoderMgr& decodemgr, bool collect_stats,
+                                    DecodeControl* control, CandidateResult& result) {
+    if (control && control->shouldStop()) return -1;
+    DecodeStats* stats = collect_stats ? &result.stats : nullptr;
+    StatsTimer timer(collect_stats);
+    bool sr_applied = false;
+    Mat scaled_buffer;
+    ImageView scaled_img =
+        super_resolution_model_->processImageScale(cropped_img, scale, use_nn_sr_, scaled_buffer, 160, &sr_applied);
+    if (stats) {
+        (sr_applied ? stats->sr_ms : stats->crop_scale_ms) += timer.lap();
+        stats->scale_attempts++;
+    }
+    vector<vector<Point2f>> zxing_points;
+    auto ret = decodemgr.decodeImage(scaled_img, use_nn_detector_, result.texts, zxing_points, result.raw_bytes,
+                                     stats, control);
+    if (ret == 0) {
+        for (auto& points_qr : zxing_points) {
+            for (auto&& pt: points_qr) {
+                pt.x /= scale;
+                pt.y /= scale;
+            }
+            result.points.push_back(std::move(points_qr));
+        }
+    }
+    return ret;
+}
+
+vector<Mat> WeChatQRCode::Impl::trackedCandidates(const StreamState& state, int width, int height) {
+    vector<Mat> candidates;
+    for (const auto& tracked : state.tracked_points) {
+        if (tracked.rows == 0) continue;
+        float min_x = tracked.ptr<float>(0)[0], max_x = min_x;
+        float min_y = tracked.ptr<float>(0)[1], max_y = min_y;
+        for (int i = 1; i < tracked.rows; i++) {
+            min_x = min(min_x, tracked.ptr<float>(i)[0]);
+            max_x = max(max_x, tracked.ptr<float>(i)[0]);
+            min_y = min(min_y, tracked.ptr<float>(i)[1]);
+            max_y = max(max_y, tracked.ptr<float>(i)[1]);
+        }
+        // expand by the code size so that the code is still inside after moving a little
+        float margin = max(max_x - min_x, max_y - min_y) * state.roi_expand;
+        float x0 = std::clamp(min_x - margin, 0.f, width - 1.f);
+        float y0 = std::clamp(min_y - margin, 0.f, height - 1.f);
+        float x1 = std::clamp(max_x + margin, 0.f, width - 1.f);
+        float y1 = std::clamp(max_y + margin, 0.f, height - 1.f);
+
+        // same layout as the detector output
+        auto point = Mat(4, 2, CV_32FC1);
+        point.ptr<float>(0)[0] = x0;
+        point.ptr<float>(0)[1] = y0;
+        point.ptr<float>(1)[0] = x1;
+        point.ptr<float>(1)[1] = y0;
+        point.ptr<float>(2)[0] = x1;
+        point.ptr<float>(2)[1] = y1;
+        point.ptr<float>(3)[0] = x0;
+        point.ptr<float>(3)[1] = y1;
+        candidates.push_back(point);
+    }
+    return candidates;
+}
+
+vector<Mat> WeChatQRCode::Impl::detect(const ImageView& img, SSDDetector::Session* session) {
     auto points = vector<Mat>();
 
     if (use_nn_detector_) {
         // use cnn detector
-        auto ret = applyDetector(img, points);
+        auto ret = applyDetector(img, points, session);
     } else {
         auto width = img.cols, height = img.rows;
         // if there is no detector, use the full image as input
@@ -199,31 +612,31 @@ vector<Mat> WeChatQRCode::Impl::detect(const Mat& img) {
     return points;
 }
 
-int WeChatQRCode::Impl::applyDetector(const Mat& img, vector<Mat>& points) {
+int WeChatQRCode::Impl::applyDetector(const ImageView& img, vector<Mat>& points, SSDDetector::Session* session) {
     int img_w = img.cols;
     int img_h = img.rows;
 
-    const float targetArea = 400.f * 400.f;
-    // hard code input size
+    const float targetArea = detector_target_area_;
     const float tmpScaleFactor = scaleFactor == -1.f ? min(1.f, sqrt(targetArea / (img_w * img_h))) : scaleFactor;
     int detect_width = img_w * tmpScaleFactor;
     int detect_height = img_h * tmpScaleFactor;
 
-    points = detector_->forward(img, detect_width, detect_height);
+    points = detector_->forward(img, detect_width, detect_height, session);
 
     return 0;
 }
 
-Mat WeChatQRCode::Impl::cropObj(const Mat& img, const Mat& point, Align& aligner) {
+ImageView WeChatQRCode::Impl::cropObj(const ImageView& img, const Mat& point, Align& aligner, Mat& rotated) {
     // make some padding to boost the qrcode details recall.
     float padding_w = 0.1f, padding_h = 0.1f;
     auto min_padding = 15;
-    auto cropped = aligner.crop(img, point, padding_w, padding_h, min_padding);
+    auto cropped = aligner.crop(img, point, padding_w, padding_h, min_padding, rotated);
     return cropped;
 }
 
 // empirical rules
 vector<float> WeChatQRCode::Impl::getScaleList(const int width, const int height) {
+    if (!scales_.empty()) return scales_;
     if (width < 320 || height < 320) return {1.0, 2.0, 0.5};
     if (width < 640 && height < 640) return {1.0, 0.5};
     return {0.5, 1.0};
@@ -49,9 +49,9 @@ Ref<BitMatrix> Binarizer::getInvertedMatrix(ErrorHandler& err_handler) {
     }
 
     if (matrixInverted_ == NULL) {
-        matrixInverted_ = new BitMatrix(matrix_->getWidth(), matrix_->getHeight(), err_handler);
-        matrixInverted_->copyOf(matrix_, err_handler);
-        matrixInverted_->flipAll();
+        matrixInverted_ = new BitMatrix(matrix_->getWidth(), matrix_->getHeight(),
+                                        matrix_->getStorage(), err_handler);
+        matrixInverted_->invertedCopyOf(matrix_, err_handler);
     }
 
     return matrixInverted_;
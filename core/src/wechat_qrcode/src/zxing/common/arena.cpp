@@ -0,0 +1,103 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+#include "../../precomp.hpp"
+#include "arena.hpp"
+#include <atomic>
+#include <new>
+
+namespace zxing {
+namespace {
+const size_t kChunkSize = 64 * 1024;
+// Every block starts with the chunk it was carved from, or null for the heap, padded so the
+// object behind it keeps the alignment operator new promises.
+const size_t kAlign = alignof(std::max_align_t);
+const size_t kMaxArenaBlock = kChunkSize / 16;
+
+struct Chunk {
+    // blocks carved from the chunk and not yet released, plus one while it is the arena's chunk
+    std::atomic<size_t> live;
+    size_t used;
+};
+const size_t kChunkHeader = (sizeof(Chunk) + kAlign - 1) / kAlign * kAlign;
+
+void releaseChunk(Chunk* chunk) {
+    if (chunk->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        chunk->~Chunk();
+        ::operator delete(chunk);
+    }
+}
+
+class ThreadArena {
+public:
+    ThreadArena() : depth_(0), chunk_(nullptr) {}
+    ~ThreadArena() {
+        if (chunk_) releaseChunk(chunk_);
+    }
+
+    bool active() const { return depth_ > 0; }
+    size_t carved() const { return chunk_ ? chunk_->used - kChunkHeader : 0; }
+    void enter() { depth_++; }
+    void leave() {
+        // nothing carved in the scope is alive, so the chunk can be handed out again
+        if (--depth_ == 0 && chunk_ && chunk_->live.load(std::memory_order_acquire) == 1) {
+            chunk_->used = kChunkHeader;
+        }
+    }
+
+    char* carve(size_t size, Chunk*& chunk) {
+        if (!chunk_ || chunk_->used + size > kChunkSize) {
+            Chunk* fresh = new (::operator new(kChunkSize)) Chunk();
+            fresh->live.store(1, std::memory_order_relaxed);
+            fresh->used = kChunkHeader;
+            if (chunk_) releaseChunk(chunk_);
+            chunk_ = fresh;
+        }
+        char* block = reinterpret_cast<char*>(chunk_) + chunk_->used;
+        chunk_->used += size;
+        chunk_->live.fetch_add(1, std::memory_order_relaxed);
+        chunk = chunk_;
+        return block;
+    }
+
+private:
+    int depth_;
+    Chunk* chunk_;
+};
+
+thread_local ThreadArena t_arena;
+}  // namespace
+
+void* CountedArena::allocate(size_t size) {
+    const size_t block_size = kAlign + (size + kAlign - 1) / kAlign * kAlign;
+    Chunk* chunk = nullptr;
+    char* block;
+    if (block_size <= kMaxArenaBlock && t_arena.active()) {
+        block = t_arena.carve(block_size, chunk);
+    } else {
+        block = static_cast<char*>(::operator new(block_size));
+    }
+    *reinterpret_cast<Chunk**>(block) = chunk;
+    return block + kAlign;
+}
+
+void CountedArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    char* block = static_cast<char*>(ptr) - kAlign;
+    Chunk* chunk = *reinterpret_cast<Chunk**>(block);
+    if (chunk) {
+        releaseChunk(chunk);
+    } else {
+        ::operator delete(block);
+    }
+}
+
+void CountedArena::enter() { t_arena.enter(); }
+
+void CountedArena::leave() { t_arena.leave(); }
+
+size_t CountedArena::carved() { return t_arena.carved(); }
+}  // namespace zxing
@@ -0,0 +1,44 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+//
+// Tencent is pleased to support the open source community by making WeChat QRCode available.
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+
+#ifndef __ZXING_COMMON_ARENA_HPP__
+#define __ZXING_COMMON_ARENA_HPP__
+
+#include <cstddef>
+
+namespace zxing {
+// Where Counted objects get their memory. While an ArenaScope is open on a thread, objects are
+// bumped out of a chunk owned by that thread, so the many small points, patterns, transforms,
+// polynomials and arrays of a decode attempt cost no malloc each. A chunk counts the objects
+// carved from it: it starts over when the outermost scope closes with none of them left, and
+// is freed once the last one dies otherwise, so objects may outlive the scope and be released on
+// any thread. Outside a scope, and for large objects, memory comes from the heap.
+class CountedArena {
+public:
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr);
+
+    static void enter();
+    static void leave();
+
+    // bytes carved from the calling thread's chunk since it last started over
+    static size_t carved();
+};
+
+// Routes the Counted objects created on this thread to its arena for the scope's lifetime.
+class ArenaScope {
+public:
+    ArenaScope() { CountedArena::enter(); }
+    ~ArenaScope() { CountedArena::leave(); }
+
+private:
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+};
+}  // namespace zxing
+
+#endif  // __ZXING_COMMON_ARENA_HPP__
@@ -26,29 +26,60 @@ public:
     Array(T const *ts, T const *te) : Counted(), values_(ts, te) {}
     Array(T v, int n) : Counted(), values_(n, v) {}
     explicit Array(std::vector<T> &v) : Counted(), values_(v) {}
-    Array(Array<T> &other) : Counted(), values_(other.values_) {}
-    explicit Array(Array<T> *other) : Counted(), values_(other->values_) {}
+    Array(Array<T> &other) : Counted(), values_(other.begin(), other.end()) {}
+    explicit Array(Array<T> *other) : Counted(), values_(other->begin(), other->end()) {}
     virtual ~Array() {}
+
+    // A read-only view of n elements owned by someone else, who keeps them alive and unchanged for
+    // as long as the view is used. The const accessors read them in place. Anything that may write,
+    // the non-const accessors, values and append, first copies them into values and drops the view.
+    static Array<T> *borrow(T const *ts, int n) {
+        Array<T> *array = new Array<T>();
+        array->borrowed_ = ts;
+        array->borrowed_size_ = n;
+        return array;
+    }
+
     Array<T> &operator=(const Array<T> &other) {
-        values_ = other.values_;
+        values_.assign(other.begin(), other.end());
+        borrowed_ = 0;
+        borrowed_size_ = 0;
         return *this;
     }
     Array<T> &operator=(const std::vector<T> &array) {
         values_ = array;
+        borrowed_ = 0;
+        borrowed_size_ = 0;
         return *this;
     }
-    T const &operator[](int i) const { return values_[i]; }
-    T &operator[](int i) { return values_[i]; }
-    int size() const { return values_.size(); }
-    bool empty() const { return values_.size() == 0; }
-    std::vector<T> const &values() const { return values_; }
-    std::vector<T> &values() { return values_; }
+    T const &operator[](int i) const { return borrowed_ ? borrowed_[i] : values_[i]; }
+    T &operator[](int i) { return own()[i]; }
+    int size() const { return borrowed_ ? borrowed_size_ : values_.size(); }
+    bool empty() const { return size() == 0; }
+    std::vector<T> &values() { return own(); }
 
+    T const *data() const { return begin(); }
     T *data() {
         // return values_.data();
-        return &values_[0];
+        return &own()[0];
+    }
+    void append(T value) { own().push_back(value); }
+
+private:
+    T const *begin() const { return borrowed_ ? borrowed_ : values_.data(); }
+    T const *end() const { return begin() + size(); }
+
+    std::vector<T> &own() {
+        if (borrowed_) {
+            values_.assign(borrowed_, borrowed_ + borrowed_size_);
+            borrowed_ = 0;
+            borrowed_size_ = 0;
+        }
+        return values_;
     }
-    void append(T value) { values_.push_back(value); }
+
+    T const *borrowed_ = 0;
+    int borrowed_size_ = 0;
 };
 
 template <typename T>
@@ -69,7 +100,7 @@ public:
         array_ = 0;
     }
 
-    T const &operator[](int i) const { return (*array_)[i]; }
+    T const &operator[](int i) const { return static_cast<Array<T> const &>(*array_)[i]; }
 
     T &operator[](int i) { return (*array_)[i]; }
 
@@ -99,6 +130,7 @@ public:
     operator bool() const { return array_ != 0; }
     bool operator!() const { return array_ == 0; }
 
+    T const *data() const { return static_cast<Array<T> const *>(array_)->data(); }
     T *data() { return array_->data(); }
 
     void clear() {
@@ -148,10 +148,10 @@ Ref<BitMatrix> AdaptiveThresholdMeanBinarizer::getBlackMatrix(ErrorHandler& err_
 int AdaptiveThresholdMeanBinarizer::binarizeImage(ErrorHandler& err_handler) {
     if (width >= BLOCK_SIZE && height >= BLOCK_SIZE) {
         LuminanceSource& source = *getLuminanceSource();
-        Ref<BitMatrix> matrix(new BitMatrix(width, height, err_handler));
+        Ref<BitMatrix> matrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
         if (err_handler.ErrCode()) return -1;
-        auto src = (unsigned char*)source.getMatrix()->data();
-        auto dst = matrix->getPtr();
+        const zxing::ArrayRef<char> luminances = source.getMatrix();
+        auto src = (const unsigned char*)luminances.data();
         cv::Mat mDst;
         mDst.create(height, width, CV_8UC1);
         TransBufferToMat(src, mDst, width, height);
@@ -161,7 +161,7 @@ int AdaptiveThresholdMeanBinarizer::binarizeImage(ErrorHandler& err_handler) {
         bs = bs + bs % 2 - 1;
         if (!(bs % 2 == 1 && bs > 1)) return -1;
         adaptiveThresholdGaussian(mDst.data, result.data, height, width, bs, Bias);
-        TransMatToBuffer(result, dst, width, height);
+        TransMatToBuffer(result, *matrix, width, height);
         if (err_handler.ErrCode()) return -1;
         matrix0_ = matrix;
     } else {
@@ -171,23 +171,24 @@ int AdaptiveThresholdMeanBinarizer::binarizeImage(ErrorHandler& err_handler) {
     return 0;
 }
 
-int AdaptiveThresholdMeanBinarizer::TransBufferToMat(unsigned char* pBuffer, cv::Mat& mDst,
+int AdaptiveThresholdMeanBinarizer::TransBufferToMat(const unsigned char* pBuffer, cv::Mat& mDst,
                                                      int nWidth, int nHeight) {
     for (int j = 0; j < nHeight; ++j) {
         unsigned char* data = mDst.ptr<unsigned char>(j);
-        unsigned char* pSubBuffer = pBuffer + (nHeight - 1 - j) * nWidth;
+        const unsigned char* pSubBuffer = pBuffer + (nHeight - 1 - j) * nWidth;
         memcpy(data, pSubBuffer, nWidth);
     }
     return 0;
 }
 
-int AdaptiveThresholdMeanBinarizer::TransMatToBuffer(cv::Mat mSrc, unsigned char* ppBuffer,
+int AdaptiveThresholdMeanBinarizer::TransMatToBuffer(cv::Mat mSrc, BitMatrix& matrix,
                                                      int& nWidth, int& nHeight) {
     nWidth = mSrc.cols;
     // nWidth = ((nWidth + 3) / 4) * 4;
     nHeight = mSrc.rows;
+    vector<unsigned char> row(nWidth);
     for (int j = 0; j < nHeight; ++j) {
-        unsigned char* pdi = ppBuffer + j * nWidth;
+        unsigned char* pdi = &row[0];
         for (int z = 0; z < nWidth; ++z) {
             int nj = nHeight - j - 1;
             int value = *(uint8_t*)(mSrc.ptr<uint8_t>(nj) + z);
@@ -196,6 +197,7 @@ int AdaptiveThresholdMeanBinarizer::TransMatToBuffer(cv::Mat mSrc, unsigned char
             else
                 pdi[z] = 1;
         }
+        matrix.setRowBytes(j, pdi);
     }
     return 0;
 }
@@ -29,8 +29,8 @@ public:
 
 private:
     int binarizeImage(ErrorHandler& err_handler);
-    int TransBufferToMat(unsigned char* pBuffer, cv::Mat& mDst, int nWidth, int nHeight);
-    int TransMatToBuffer(cv::Mat mSrc, unsigned char* ppBuffer, int& nWidth, int& nHeight);
+    int TransBufferToMat(const unsigned char* pBuffer, cv::Mat& mDst, int nWidth, int nHeight);
+    int TransMatToBuffer(cv::Mat mSrc, BitMatrix& matrix, int& nWidth, int& nHeight);
 };
 
 }  // namespace zxing
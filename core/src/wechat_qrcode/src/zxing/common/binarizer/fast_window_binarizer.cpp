@@ -162,21 +162,20 @@ void FastWindowBinarizer::fastIntegral(const unsigned char* inputMatrix,
 
 int FastWindowBinarizer::binarizeImage1(ErrorHandler& err_handler) {
     LuminanceSource& source = *getLuminanceSource();
-    Ref<BitMatrix> matrix(new BitMatrix(width, height, err_handler));
+    Ref<BitMatrix> matrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
     if (err_handler.ErrCode()) return -1;
 
-    ArrayRef<char> localLuminances = source.getMatrix();
+    const ArrayRef<char> localLuminances = source.getMatrix();
 
-    unsigned char* src = (unsigned char*)localLuminances->data();
-    unsigned char* dst = matrix->getPtr();
-    fastWindow(src, dst, err_handler);
+    const unsigned char* src = (const unsigned char*)localLuminances.data();
+    fastWindow(src, *matrix, err_handler);
     if (err_handler.ErrCode()) return -1;
 
     matrix0_ = matrix;
     return 0;
 }
 
-void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* dst,
+void FastWindowBinarizer::fastWindow(const unsigned char* src, BitMatrix& matrix,
                                      ErrorHandler& err_handler) {
     int r = (int)(min(width, height) * WINDOW_FRACTION / BLOCK_SIZE / 2 + 1);
     const int NEWH_BLOCK_SIZE = BLOCK_SIZE * r;
@@ -188,8 +187,12 @@ void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* ds
     fastIntegral(_img, _internal);
     int aw = width / BLOCK_SIZE;
     int ah = height / BLOCK_SIZE;
-    memset(dst, 0, sizeof(char) * height * width);
+    // One row of blocks at a time in bytes, packed into the matrix when done. Rows and columns
+    // past the last whole block stay clear.
+    vector<unsigned char> band((size_t)BLOCK_SIZE * width);
+    unsigned char* dst = &band[0];
     for (int ai = 0; ai < ah; ai++) {
+        memset(dst, 0, band.size());
         int top = max(0, ((ai - r + 1) * BLOCK_SIZE));
         int bottom = min(height, (ai + r) * BLOCK_SIZE);
         unsigned int* pt = _internal + top * (width + 1);
@@ -202,7 +205,7 @@ void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* ds
             int avg = (int)block / pixels;
             for (int bi = ai * BLOCK_SIZE; bi < height && bi < (ai + 1) * BLOCK_SIZE; bi++) {
                 const unsigned char* psi = src + bi * width;
-                unsigned char* pdi = dst + bi * width;
+                unsigned char* pdi = dst + (bi - ai * BLOCK_SIZE) * width;
                 for (int bj = aj * BLOCK_SIZE; bj < width && bj < (aj + 1) * BLOCK_SIZE; bj++) {
                     if ((int)psi[bj] < avg)
                         pdi[bj] = 1;
@@ -211,6 +214,9 @@ void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* ds
                 }
             }
         }
+        for (int bi = 0; bi < BLOCK_SIZE; bi++) {
+            matrix.setRowBytes(ai * BLOCK_SIZE + bi, dst + bi * width);
+        }
     }
     // delete [] _internal;
     return;
@@ -229,7 +235,7 @@ int FastWindowBinarizer::binarizeImage0(ErrorHandler& err_handler) {
         int ah = height / BLOCK_SIZE;
         int ow = aw + 1;
 
-        ArrayRef<char> _luminances = source.getMatrix();
+        const ArrayRef<char> _luminances = source.getMatrix();
 
         // Get luminances for int value first
         for (int i = 0; i < width * height; i++) {
@@ -240,9 +246,10 @@ int FastWindowBinarizer::binarizeImage0(ErrorHandler& err_handler) {
 
         cumulative(_blockTotals, _totals, aw, ah);
 
-        Ref<BitMatrix> newMatrix(new BitMatrix(width, height, err_handler));
+        Ref<BitMatrix> newMatrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
         if (err_handler.ErrCode()) return -1;
-        unsigned char* newimg = newMatrix->getPtr();
+        vector<unsigned char> band((size_t)BLOCK_SIZE * width);
+        unsigned char* newimg = &band[0];
         for (int by = 0; by < ah; by++) {
             int top = max(0, by - r + 1);
             int bottom = min(ah, by + r);
@@ -260,7 +267,7 @@ int FastWindowBinarizer::binarizeImage0(ErrorHandler& err_handler) {
                 for (int y = by * BLOCK_SIZE; y < (by + 1) * BLOCK_SIZE; y++) {
                     // int offset = y*width;
                     int* plumint = _luminancesInt + y * width;
-                    unsigned char* pn = newimg + y * width;
+                    unsigned char* pn = newimg + (y - by * BLOCK_SIZE) * width;
                     for (int x = bx * BLOCK_SIZE; x < (bx + 1) * BLOCK_SIZE; x++) {
                         // int pixel = luminances[y*width + x] & 0xff;
                         // if(plumint[x] < avg)
@@ -272,6 +279,9 @@ int FastWindowBinarizer::binarizeImage0(ErrorHandler& err_handler) {
                     }
                 }
             }
+            for (int y = 0; y < BLOCK_SIZE; y++) {
+                newMatrix->setRowBytes(by * BLOCK_SIZE + y, newimg + y * width);
+            }
         }
         // delete[] data;
         matrix_ = newMatrix;
@@ -48,7 +48,7 @@ private:
     int binarizeImage0(ErrorHandler& err_handler);
     void fastIntegral(const unsigned char* inputMatrix, unsigned int* outputMatrix);
     int binarizeImage1(ErrorHandler& err_handler);
-    void fastWindow(const unsigned char* src, unsigned char* dst, ErrorHandler& err_handler);
+    void fastWindow(const unsigned char* src, BitMatrix& matrix, ErrorHandler& err_handler);
 };
 
 }  // namespace zxing
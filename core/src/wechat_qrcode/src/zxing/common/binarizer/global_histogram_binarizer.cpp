@@ -264,7 +264,7 @@ int GlobalHistogramBinarizer::estimateBlackPoint2(ArrayRef<int> const& _buckets)
 
 int GlobalHistogramBinarizer::binarizeImage0(ErrorHandler& err_handler) {
     LuminanceSource& source = *getLuminanceSource();
-    Ref<BitMatrix> matrix(new BitMatrix(width, height, err_handler));
+    Ref<BitMatrix> matrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
     if (err_handler.ErrCode()) return -1;
     // Quickly calculates the histogram by sampling four rows from the image.
     // This proved to be more robust on the blackbox tests than sampling a
@@ -287,7 +287,7 @@ int GlobalHistogramBinarizer::binarizeImage0(ErrorHandler& err_handler) {
     int blackPoint = estimateBlackPoint(localBuckets, err_handler);
     if (err_handler.ErrCode()) return -1;
 
-    ArrayRef<char> localLuminances = source.getMatrix();
+    const ArrayRef<char> localLuminances = source.getMatrix();
     for (int y = 0; y < height; y++) {
         int offset = y * width;
         for (int x = 0; x < width; x++) {
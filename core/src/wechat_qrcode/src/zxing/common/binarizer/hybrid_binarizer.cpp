@@ -180,6 +180,9 @@ void HybridBinarizer::calculateThresholdForBlock(Ref<ByteMatrix>& _luminances, i
 
     int blockArea = ((2 * THRES_BLOCKSIZE + 1) * (2 * THRES_BLOCKSIZE + 1));
 
+    // Each row of blocks is thresholded into bytes and then packed into the matrix
+    vector<unsigned char> band((size_t)block_size * width);
+
     for (int y = 0; y < subHeight; y++) {
         int yoffset = y << SIZE_POWER;
         if (yoffset > maxYOffset) {
@@ -205,9 +208,12 @@ void HybridBinarizer::calculateThresholdForBlock(Ref<ByteMatrix>& _luminances, i
                   blockIntegral[offset2] + blockIntegral[offset2 + blocksize];
 
             int average = sum / blockArea;
-            thresholdBlock(_luminances, xoffset, yoffset, average, matrix, err_handler);
+            thresholdBlock(_luminances, xoffset, yoffset, average, &band[0], err_handler);
             if (err_handler.ErrCode()) return;
         }
+        for (int row = 0; row < block_size; row++) {
+            matrix->setRowBytes(yoffset + row, &band[(size_t)row * width]);
+        }
     }
 }
 
@@ -239,17 +245,16 @@ void HybridBinarizer::thresholdFourBlocks(Ref<ByteMatrix>& luminances, int xoffs
 
 // Applies a single threshold to a block of pixels
 void HybridBinarizer::thresholdBlock(Ref<ByteMatrix>& _luminances, int xoffset, int yoffset,
-                                     int threshold, Ref<BitMatrix> const& matrix,
+                                     int threshold, unsigned char* band,
                                      ErrorHandler& err_handler) {
-    int rowBitsSize = matrix->getRowBitsSize();
     int rowSize = width;
 
-    int rowBitStep = rowBitsSize - BLOCK_SIZE;
+    int rowBitStep = rowSize - BLOCK_SIZE;
     int rowStep = rowSize - BLOCK_SIZE;
 
     unsigned char* pTemp = _luminances->getByteRow(yoffset, err_handler);
     if (err_handler.ErrCode()) return;
-    bool* bpTemp = matrix->getRowBoolPtr(yoffset);
+    unsigned char* bpTemp = band;
 
     pTemp += xoffset;
     bpTemp += xoffset;
@@ -258,7 +263,7 @@ void HybridBinarizer::thresholdBlock(Ref<ByteMatrix>& _luminances, int xoffset,
         for (int x = 0; x < BLOCK_SIZE; x++) {
             // comparison needs to be <= so that black == 0 pixels are black
             // even if the threshold is 0.
-            *bpTemp++ = (*pTemp++ <= threshold) ? true : false;
+            *bpTemp++ = (*pTemp++ <= threshold) ? 1 : 0;
         }
 
         pTemp += rowBitStep;
@@ -399,7 +404,7 @@ int HybridBinarizer::getBlockThreshold(int x, int y, int subWidth, int sum, int
 
 int HybridBinarizer::binarizeByBlock(ErrorHandler& err_handler) {
     if (width >= MINIMUM_DIMENSION && height >= MINIMUM_DIMENSION) {
-        Ref<BitMatrix> newMatrix(new BitMatrix(width, height, err_handler));
+        Ref<BitMatrix> newMatrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
         if (err_handler.ErrCode()) return -1;
 
         calculateThresholdForBlock(grayByte_, subWidth_, subHeight_, BLOCK_SIZE_POWER, newMatrix,
@@ -63,8 +63,9 @@ private:
                                     ErrorHandler& err_handler);
 
 
+    // band holds the block row starting at yoffset, one byte per pixel
     void thresholdBlock(Ref<ByteMatrix>& luminances, int xoffset, int yoffset, int threshold,
-                        Ref<BitMatrix> const& matrix, ErrorHandler& err_handler);
+                        unsigned char* band, ErrorHandler& err_handler);
 
     void thresholdIrregularBlock(Ref<ByteMatrix>& luminances, int xoffset, int yoffset,
                                  int blockWidth, int blockHeight, int threshold,
@@ -52,15 +52,14 @@ using namespace std;
 int SimpleAdaptiveBinarizer::binarizeImage0(ErrorHandler &err_handler) {
     LuminanceSource &source = *getLuminanceSource();
 
-    Ref<BitMatrix> matrix(new BitMatrix(width, height, err_handler));
+    Ref<BitMatrix> matrix(new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
     if (err_handler.ErrCode()) return -1;
 
-    ArrayRef<char> localLuminances = source.getMatrix();
+    const ArrayRef<char> localLuminances = source.getMatrix();
 
-    unsigned char *src = (unsigned char *)localLuminances->data();
-    unsigned char *dst = matrix->getPtr();
+    const unsigned char *src = (const unsigned char *)localLuminances.data();
 
-    qrBinarize(src, dst);
+    qrBinarize(src, *matrix);
 
     matrix0_ = matrix;
 
@@ -70,10 +69,10 @@ int SimpleAdaptiveBinarizer::binarizeImage0(ErrorHandler &err_handler) {
 /*A simplified adaptive thresholder.
   This compares the current pixel value to the mean value of a (large) window
    surrounding it.*/
-int SimpleAdaptiveBinarizer::qrBinarize(const unsigned char *src, unsigned char *dst) {
-    unsigned char *mask = dst;
-
+int SimpleAdaptiveBinarizer::qrBinarize(const unsigned char *src, BitMatrix &matrix) {
     if (width > 0 && height > 0) {
+        /*One row of the mask at a time, packed into the matrix when done.*/
+        vector<unsigned char> mask(width);
         unsigned *col_sums;
         int logwindw;
         int logwindh;
@@ -126,7 +125,7 @@ int SimpleAdaptiveBinarizer::qrBinarize(const unsigned char *src, unsigned char
                 /*Perform the test against the threshold T = (m/n)-D,
                    where n=windw*windh and D=3.*/
                 g = src[offset + x];
-                mask[offset + x] = ((g + 3) << (logwinds) < m);
+                mask[x] = ((g + 3) << (logwinds) < m);
                 /*Update the window sum.*/
                 if (x + 1 < width) {
                     x0 = max(0, x - (windw >> 1));
@@ -134,6 +133,7 @@ int SimpleAdaptiveBinarizer::qrBinarize(const unsigned char *src, unsigned char
                     m += col_sums[x1] - col_sums[x0];
                 }
             }
+            matrix.setRowBytes(y, &mask[0]);
             /*Update the column sums.*/
             if (y + 1 < height) {
                 y0offs = max(0, y - (windh >> 1)) * width;
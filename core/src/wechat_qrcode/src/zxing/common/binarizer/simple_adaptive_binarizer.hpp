@@ -31,7 +31,7 @@ public:
 
 private:
     int binarizeImage0(ErrorHandler &err_handler);
-    int qrBinarize(const unsigned char *src, unsigned char *dst);
+    int qrBinarize(const unsigned char *src, BitMatrix &matrix);
     bool filtered;
 };
 
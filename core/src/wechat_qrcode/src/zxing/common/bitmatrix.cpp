@@ -16,7 +16,71 @@ using zxing::BitMatrix;
 using zxing::ErrorHandler;
 using zxing::Ref;
 
-void BitMatrix::init(int _width, int _height, ErrorHandler& err_handler) {
+namespace {
+// Eight 0-or-1 pixels at once.
+const uint64_t kWordOnes = 0x0101010101010101ULL;
+
+inline uint64_t loadWord(const unsigned char* p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+inline void storeWord(unsigned char* p, uint64_t word) { memcpy(p, &word, sizeof(word)); }
+
+// Eight 0-or-1 bytes to the eight low bits of a packed word and back, byte i being bit i on the
+// little-endian targets this builds for.
+inline unsigned int packByteWord(uint64_t bytes) {
+    return (unsigned int)((bytes * 0x0102040810204080ULL) >> 56);
+}
+
+inline uint64_t unpackByteWord(unsigned int packed) {
+    uint64_t spread = ((uint64_t)packed * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    return ((spread + 0x7F7F7F7F7F7F7F7FULL) >> 7) & kWordOnes;
+}
+
+inline int lowestSetBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int n = 0;
+    while (!(word & 0xFF)) {
+        word >>= 8;
+        n += 8;
+    }
+    while (!(word & 1)) {
+        word >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+inline int highestSetBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(word);
+#else
+    int n = 63;
+    while (!(word >> 56)) {
+        word <<= 8;
+        n -= 8;
+    }
+    while (!(word >> 63)) {
+        word <<= 1;
+        n--;
+    }
+    return n;
+#endif
+}
+
+// Pixels of the last word of a row that lie inside the row
+inline uint64_t tailMask(int width) {
+    return (width & 63) ? (((uint64_t)1 << (width & 63)) - 1) : ~(uint64_t)0;
+}
+}  // namespace
+
+void BitMatrix::init(int _width, int _height, Storage _storage, ErrorHandler& err_handler) {
+    storage = _storage;
     if (_width < 1 || _height < 1) {
         err_handler = IllegalArgumentErrorHandler("Both dimensions must be greater than 0");
         return;
@@ -24,6 +88,17 @@ void BitMatrix::init(int _width, int _height, ErrorHandler& err_handler) {
     width = _width;
     height = _height;
     this->rowBitsSize = width;
+    isInitRowCounters = false;
+
+    if (storage == BIT_PACKED) {
+        rowWords = (width + 63) >> 6;
+        words.assign((size_t)rowWords * height, 0);
+        bits = ArrayRef<unsigned char>();
+        rowOffsets = ArrayRef<int>();
+        return;
+    }
+    rowWords = 0;
+    vector<uint64_t>().swap(words);
     bits = ArrayRef<unsigned char>(width * height);
     rowOffsets = ArrayRef<int>(height);
 
@@ -32,13 +107,10 @@ void BitMatrix::init(int _width, int _height, ErrorHandler& err_handler) {
     for (int i = 1; i < height; i++) {
         rowOffsets[i] = rowOffsets[i - 1] + width;
     }
-
-    isInitRowCounters = false;
-    isInitColsCounters = false;
 }
 
 void BitMatrix::init(int _width, int _height, unsigned char* bitsPtr, ErrorHandler& err_handler) {
-    init(_width, _height, err_handler);
+    init(_width, _height, BYTE_PER_PIXEL, err_handler);
     if (err_handler.ErrCode()) return;
     memcpy(bits->data(), bitsPtr, width * height * sizeof(unsigned char));
 }
@@ -48,79 +120,204 @@ void BitMatrix::initRowCounters() {
         return;
     }
 
-    row_counters = vector<COUNTER_TYPE>(width * height, 0);
-    row_counters_offset = vector<COUNTER_TYPE>(width * height, 0);
-    row_point_offset = vector<COUNTER_TYPE>(width * height, 0);
-    row_counter_offset_end = vector<COUNTER_TYPE>(height, 0);
-
-    row_counters_recorded = vector<bool>(height, false);
+    // Every row in one pass, storing only its runs. A binarized image averages a run every few
+    // pixels, so this takes a fraction of a per-pixel table.
+    row_run_begin.resize(height + 1);
+    row_run_lengths.clear();
+    row_run_offsets.clear();
+    for (int y = 0; y < height; y++) {
+        row_run_begin[y] = static_cast<int>(row_run_lengths.size());
+        if (storage == BIT_PACKED) {
+            appendPackedRowRuns(y);
+        } else {
+            appendRowRuns(y);
+        }
+    }
+    row_run_begin[height] = static_cast<int>(row_run_lengths.size());
 
     isInitRowCounters = true;
 }
-void BitMatrix::initColsCounters() {
-    if (isInitColsCounters == true) {
-        return;
-    }
 
-    cols_counters = vector<COUNTER_TYPE>(width * height, 0);
-    cols_counters_offset = vector<COUNTER_TYPE>(width * height, 0);
-    cols_point_offset = vector<COUNTER_TYPE>(width * height, 0);
-    cols_counter_offset_end = vector<COUNTER_TYPE>(width, 0);
-
-    cols_counters_recorded = vector<bool>(width, false);
+void BitMatrix::appendRowRuns(int y) {
+    const unsigned char* row = bits->data() + rowOffsets[y];
+    unsigned char color = row[0];
+    int start = 0;
+    int x = 1;
+    while (x < width) {
+        // eight pixels that all continue the current run
+        if (x + 8 <= width && loadWord(row + x) == (color ? kWordOnes : 0)) {
+            x += 8;
+            continue;
+        }
+        if (row[x] != color) {
+            row_run_lengths.push_back(x - start);
+            row_run_offsets.push_back(start);
+            start = x;
+            color = row[x];
+        }
+        x++;
+    }
+    row_run_lengths.push_back(width - start);
+    row_run_offsets.push_back(start);
+}
 
-    isInitColsCounters = true;
+void BitMatrix::appendPackedRowRuns(int y) {
+    const uint64_t* row = &words[(size_t)y * rowWords];
+    int color = (int)(row[0] & 1);
+    int start = 0;
+    int x = 1;
+    while (x < width) {
+        // pixels from x on that differ from the current run; inverting a black run also sets
+        // the clear bits past the width, which ends the last run there
+        uint64_t word = row[x >> 6] ^ (color ? ~(uint64_t)0 : 0);
+        word &= ~(uint64_t)0 << (x & 63);
+        if (!word) {
+            x = (x | 63) + 1;
+            continue;
+        }
+        x = (x & ~63) + lowestSetBit(word);
+        if (x >= width) break;
+        row_run_lengths.push_back(x - start);
+        row_run_offsets.push_back(start);
+        start = x;
+        color ^= 1;
+        x++;
+    }
+    row_run_lengths.push_back(width - start);
+    row_run_offsets.push_back(start);
 }
 
 BitMatrix::BitMatrix(int dimension, ErrorHandler& err_handler) {
-    init(dimension, dimension, err_handler);
+    init(dimension, dimension, BYTE_PER_PIXEL, err_handler);
 }
 
 BitMatrix::BitMatrix(int _width, int _height, ErrorHandler& err_handler) {
-    init(_width, _height, err_handler);
+    init(_width, _height, BYTE_PER_PIXEL, err_handler);
+}
+
+BitMatrix::BitMatrix(int _width, int _height, Storage _storage, ErrorHandler& err_handler) {
+    init(_width, _height, _storage, err_handler);
 }
 
 BitMatrix::BitMatrix(int _width, int _height, unsigned char* bitsPtr, ErrorHandler& err_handler) {
     init(_width, _height, bitsPtr, err_handler);
 }
-// Copy bitMatrix
-void BitMatrix::copyOf(Ref<BitMatrix> _bits, ErrorHandler& err_handler) {
+void BitMatrix::resizeFor(Ref<BitMatrix> _bits, ErrorHandler& err_handler) {
     int _width = _bits->getWidth();
     int _height = _bits->getHeight();
-    init(_width, _height, err_handler);
+    Storage _storage = _bits->getStorage();
+    bool allocated = storage == BIT_PACKED ? !words.empty() : !!bits;
+    if (!allocated || _storage != storage || _width != width || _height != height) {
+        init(_width, _height, _storage, err_handler);
+    } else {
+        // same size, keep the storage and only drop the run records of the old content
+        isInitRowCounters = false;
+    }
+}
 
-    for (int y = 0; y < height; y++) {
-        bool* rowPtr = _bits->getRowBoolPtr(y);
-        setRowBool(y, rowPtr);
+// Copy bitMatrix
+void BitMatrix::copyOf(Ref<BitMatrix> _bits, ErrorHandler& err_handler) {
+    resizeFor(_bits, err_handler);
+    if (err_handler.ErrCode()) return;
+
+    if (storage == BIT_PACKED) {
+        std::copy(_bits->words.begin(), _bits->words.end(), words.begin());
+        return;
     }
+    // rows are packed, so the whole matrix is one block
+    memcpy(bits->data(), _bits->getPtr(), (size_t)width * height);
 }
 
-void BitMatrix::xxor(Ref<BitMatrix> _bits) {
-    if (width != _bits->getWidth() || height != _bits->getHeight()) {
+void BitMatrix::invertedCopyOf(Ref<BitMatrix> _bits, ErrorHandler& err_handler) {
+    resizeFor(_bits, err_handler);
+    if (err_handler.ErrCode()) return;
+
+    if (storage == BIT_PACKED) {
+        const uint64_t* src = _bits->words.data();
+        uint64_t lastMask = tailMask(width);
+        for (int y = 0; y < height; y++) {
+            size_t rowStart = (size_t)y * rowWords;
+            for (int i = 0; i < rowWords; i++) {
+                words[rowStart + i] = ~src[rowStart + i];
+            }
+            words[rowStart + rowWords - 1] &= lastMask;
+        }
         return;
     }
 
-    for (int y = 0; y < height && y < _bits->getHeight(); ++y) {
-        bool* rowPtrA = _bits->getRowBoolPtr(y);
-        bool* rowPtrB = getRowBoolPtr(y);
+    unsigned char* dst = bits->data();
+    const unsigned char* src = _bits->getPtr();
+    size_t size = (size_t)width * height;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        storeWord(dst + i, loadWord(src + i) ^ kWordOnes);
+    }
+    for (; i < size; i++) {
+        dst[i] = src[i] ^ 1;
+    }
+}
 
-        for (int x = 0; x < width && x < _bits->getWidth(); ++x) {
-            rowPtrB[x] = rowPtrB[x] ^ rowPtrA[x];
+void BitMatrix::xxor(Ref<BitMatrix> _bits) {
+    if (width != _bits->getWidth() || height != _bits->getHeight()) {
+        return;
+    }
+    if (storage != _bits->getStorage()) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (_bits->get(x, y)) flip(x, y);
+            }
         }
-        setRowBool(y, rowPtrB);
+        return;
+    }
+    if (storage == BIT_PACKED) {
+        for (size_t i = 0; i < words.size(); i++) {
+            words[i] ^= _bits->words[i];
+        }
+        return;
+    }
+
+    unsigned char* dst = bits->data();
+    const unsigned char* src = _bits->getPtr();
+    size_t size = (size_t)width * height;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        storeWord(dst + i, loadWord(dst + i) ^ loadWord(src + i));
+    }
+    for (; i < size; i++) {
+        dst[i] ^= src[i];
     }
 }
 
 BitMatrix::~BitMatrix() {}
 
 void BitMatrix::flip(int x, int y) {
+    if (storage == BIT_PACKED) {
+        words[(size_t)y * rowWords + (x >> 6)] ^= (uint64_t)1 << (x & 63);
+        return;
+    }
     bits[rowOffsets[y] + x] = (bits[rowOffsets[y] + x] == (unsigned char)0);
 }
 
 void BitMatrix::flipAll() {
-    bool* matrixBits = (bool*)bits->data();
-    for (int i = 0; i < bits->size(); i++) {
-        matrixBits[i] = !matrixBits[i];
+    if (storage == BIT_PACKED) {
+        uint64_t lastMask = tailMask(width);
+        for (int y = 0; y < height; y++) {
+            size_t rowStart = (size_t)y * rowWords;
+            for (int i = 0; i < rowWords; i++) {
+                words[rowStart + i] = ~words[rowStart + i];
+            }
+            words[rowStart + rowWords - 1] &= lastMask;
+        }
+        return;
+    }
+    unsigned char* matrixBits = bits->data();
+    size_t size = bits->size();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        storeWord(matrixBits + i, loadWord(matrixBits + i) ^ kWordOnes);
+    }
+    for (; i < size; i++) {
+        matrixBits[i] ^= 1;
     }
 }
 
@@ -142,7 +339,7 @@ void BitMatrix::flipRegion(int left, int top, int _width, int _height, ErrorHand
 
     for (int y = top; y < bottom; y++) {
         for (int x = left; x < right; x++) {
-            bits[rowOffsets[y] + x] ^= 1;
+            flip(x, y);
         }
     }
 }
@@ -164,9 +361,10 @@ void BitMatrix::setRegion(int left, int top, int _width, int _height, ErrorHandl
     }
 
     for (int y = top; y < bottom; y++) {
-        for (int x = left; x < right; x++) {
-            bits[rowOffsets[y] + x] = true;
-            // bits[rowOffsets[y]+x] |= 0xFF;
+        if (storage == BIT_PACKED) {
+            for (int x = left; x < right; x++) set(x, y);
+        } else {
+            memset(bits->data() + rowOffsets[y] + left, 1, _width);
         }
     }
 }
@@ -176,15 +374,29 @@ Ref<BitArray> BitMatrix::getRow(int y, Ref<BitArray> row) {
         row = new BitArray(width);
     }
 
-    // row->
-    unsigned char* src = bits.data() + rowOffsets[y];
-    row->setOneRow(src, width);
+    getRowBool(y, row->getRowBoolPtr());
 
     return row;
 }
 
 ArrayRef<int> BitMatrix::getTopLeftOnBit() const {
+    if (storage == BIT_PACKED) {
+        size_t i = 0;
+        while (i < words.size() && words[i] == 0) i++;
+        if (i == words.size()) {
+            return ArrayRef<int>();
+        }
+        ArrayRef<int> res(2);
+        res[0] = (int)(i % rowWords) * 64 + lowestSetBit(words[i]);
+        res[1] = (int)(i / rowWords);
+        return res;
+    }
+
     int bitsOffset = 0;
+    const unsigned char* matrixBits = bits->data();
+    while (bitsOffset + 8 <= bits->size() && loadWord(matrixBits + bitsOffset) == 0) {
+        bitsOffset += 8;
+    }
     while (bitsOffset < bits->size() && bits[bitsOffset] == 0) {
         bitsOffset++;
     }
@@ -200,7 +412,24 @@ ArrayRef<int> BitMatrix::getTopLeftOnBit() const {
 }
 
 ArrayRef<int> BitMatrix::getBottomRightOnBit() const {
+    if (storage == BIT_PACKED) {
+        size_t i = words.size();
+        while (i > 0 && words[i - 1] == 0) i--;
+        if (i == 0) {
+            return ArrayRef<int>();
+        }
+        i--;
+        ArrayRef<int> res(2);
+        res[0] = (int)(i % rowWords) * 64 + highestSetBit(words[i]);
+        res[1] = (int)(i / rowWords);
+        return res;
+    }
+
     int bitsOffset = bits->size() - 1;
+    const unsigned char* matrixBits = bits->data();
+    while (bitsOffset >= 7 && loadWord(matrixBits + bitsOffset - 7) == 0) {
+        bitsOffset -= 8;
+    }
     while (bitsOffset >= 0 && bits[bitsOffset] == 0) {
         bitsOffset--;
     }
@@ -217,17 +446,47 @@ ArrayRef<int> BitMatrix::getBottomRightOnBit() const {
 }
 
 void BitMatrix::getRowBool(int y, bool* getrow) {
+    if (storage == BIT_PACKED) {
+        const uint64_t* src = &words[(size_t)y * rowWords];
+        unsigned char* dst = reinterpret_cast<unsigned char*>(getrow);
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            storeWord(dst + x, unpackByteWord((unsigned int)(src[x >> 6] >> (x & 63)) & 0xFF));
+        }
+        for (; x < width; x++) {
+            dst[x] = (unsigned char)((src[x >> 6] >> (x & 63)) & 1);
+        }
+        return;
+    }
     int offset = rowOffsets[y];
     unsigned char* src = bits.data() + offset;
     memcpy(getrow, src, rowBitsSize * sizeof(bool));
 }
 
 void BitMatrix::setRowBool(int y, bool* row) {
-    int offset = rowOffsets[y];
-    unsigned char* dst = bits.data() + offset;
-    memcpy(dst, row, rowBitsSize * sizeof(bool));
+    setRowBytes(y, reinterpret_cast<const unsigned char*>(row));
+}
 
-    return;
+void BitMatrix::setRowBytes(int y, const unsigned char* row) {
+    isInitRowCounters = false;
+    if (storage == BIT_PACKED) {
+        uint64_t* dst = &words[(size_t)y * rowWords];
+        for (int i = 0; i < rowWords; i++) {
+            int begin = i << 6;
+            int end = std::min(begin + 64, width);
+            uint64_t word = 0;
+            int x = begin;
+            for (; x + 8 <= end; x += 8) {
+                word |= (uint64_t)packByteWord(loadWord(row + x)) << (x & 63);
+            }
+            for (; x < end; x++) {
+                word |= (uint64_t)(row[x] & 1) << (x & 63);
+            }
+            dst[i] = word;
+        }
+        return;
+    }
+    memcpy(bits.data() + rowOffsets[y], row, rowBitsSize);
 }
 
 bool* BitMatrix::getRowBoolPtr(int y) {
@@ -237,6 +496,10 @@ bool* BitMatrix::getRowBoolPtr(int y) {
 }
 
 void BitMatrix::clear() {
+    if (storage == BIT_PACKED) {
+        std::fill(words.begin(), words.end(), 0);
+        return;
+    }
     int size = bits->size();
 
     unsigned char* dst = bits->data();
@@ -247,32 +510,9 @@ int BitMatrix::getWidth() const { return width; }
 
 int BitMatrix::getHeight() const { return height; }
 
-COUNTER_TYPE* BitMatrix::getRowPointInRecords(int y) {
-    if (!row_point_offset[y]) {
-        setRowRecords(y);
-    }
-    int offset = y * width;
-    COUNTER_TYPE* counters = &row_point_offset[0] + offset;
-    return (COUNTER_TYPE*)counters;
-}
+COUNTER_TYPE* BitMatrix::getRowRecords(int y) { return &row_run_lengths[row_run_begin[y]]; }
 
-COUNTER_TYPE* BitMatrix::getRowRecords(int y) {
-    if (!row_counters_recorded[y]) {
-        setRowRecords(y);
-    }
-    int offset = y * width;
-    COUNTER_TYPE* counters = &row_counters[0] + offset;
-    return (COUNTER_TYPE*)counters;
-}
-
-COUNTER_TYPE* BitMatrix::getRowRecordsOffset(int y) {
-    if (!row_counters_recorded[y]) {
-        setRowRecords(y);
-    }
-    int offset = y * width;
-    COUNTER_TYPE* counters = &row_counters_offset[0] + offset;
-    return (COUNTER_TYPE*)counters;
-}
+COUNTER_TYPE* BitMatrix::getRowRecordsOffset(int y) { return &row_run_offsets[row_run_begin[y]]; }
 
 bool BitMatrix::getRowFirstIsWhite(int y) {
     bool is_white = !get(0, y);
@@ -285,113 +525,5 @@ bool BitMatrix::getRowLastIsWhite(int y) {
 }
 
 COUNTER_TYPE BitMatrix::getRowCounterOffsetEnd(int y) {
-    if (!row_counters_recorded[y]) {
-        setRowRecords(y);
-    }
-    return row_counter_offset_end[y];
-}
-
-void BitMatrix::setRowRecords(int y) {
-    COUNTER_TYPE* cur_row_counters = &row_counters[0] + y * width;
-    COUNTER_TYPE* cur_row_counters_offset = &row_counters_offset[0] + y * width;
-    COUNTER_TYPE* cur_row_point_in_counters = &row_point_offset[0] + y * width;
-    int end = width;
-
-    bool* rowBit = getRowBoolPtr(y);
-    bool isWhite = !rowBit[0];
-    int counterPosition = 0;
-    int i = 0;
-    cur_row_counters_offset[0] = 0;
-    while (i < end) {
-        if (rowBit[i] ^ isWhite) {  // that is, exactly one is true
-            cur_row_counters[counterPosition]++;
-        } else {
-            counterPosition++;
-            if (counterPosition == end) {
-                break;
-            } else {
-                cur_row_counters[counterPosition] = 1;
-                isWhite = !isWhite;
-                cur_row_counters_offset[counterPosition] = i;
-            }
-        }
-        cur_row_point_in_counters[i] = counterPosition;
-        i++;
-    }
-
-    // use the last row__onedReaderData->counter_size to record
-    // _onedReaderData->counter_size
-    row_counter_offset_end[y] = counterPosition < end ? (counterPosition + 1) : end;
-
-    row_counters_recorded[y] = true;
-    return;
-}
-
-COUNTER_TYPE* BitMatrix::getColsPointInRecords(int x) {
-    if (!cols_point_offset[x]) {
-        setColsRecords(x);
-    }
-    int offset = x * height;
-    COUNTER_TYPE* counters = &cols_point_offset[0] + offset;
-    return (COUNTER_TYPE*)counters;
+    return static_cast<COUNTER_TYPE>(row_run_begin[y + 1] - row_run_begin[y]);
 }
-
-COUNTER_TYPE* BitMatrix::getColsRecords(int x) {
-    if (!cols_counters_recorded[x]) {
-        setColsRecords(x);
-    }
-    int offset = x * height;
-    COUNTER_TYPE* counters = &cols_counters[0] + offset;
-    return (COUNTER_TYPE*)counters;
-}
-
-COUNTER_TYPE* BitMatrix::getColsRecordsOffset(int x) {
-    if (!cols_counters_recorded[x]) {
-        setColsRecords(x);
-    }
-    int offset = x * height;
-    COUNTER_TYPE* counters = &cols_counters_offset[0] + offset;
-    return (COUNTER_TYPE*)counters;
-}
-
-COUNTER_TYPE BitMatrix::getColsCounterOffsetEnd(int x) {
-    if (!cols_counters_recorded[x]) {
-        setColsRecords(x);
-    }
-    return cols_counter_offset_end[x];
-}
-
-void BitMatrix::setColsRecords(int x) {
-    COUNTER_TYPE* cur_cols_counters = &cols_counters[0] + x * height;
-    COUNTER_TYPE* cur_cols_counters_offset = &cols_counters_offset[0] + x * height;
-    COUNTER_TYPE* cur_cols_point_in_counters = &cols_point_offset[0] + x * height;
-    int end = height;
-
-    bool* rowBit = getRowBoolPtr(0);
-    bool isWhite = !rowBit[0];
-    int counterPosition = 0;
-    int i = 0;
-    cur_cols_counters_offset[0] = 0;
-    while (i < end) {
-        if (rowBit[i] ^ isWhite) {  // that is, exactly one is true
-            cur_cols_counters[counterPosition]++;
-        } else {
-            counterPosition++;
-            if (counterPosition == end) {
-                break;
-            } else {
-                cur_cols_counters[counterPosition] = 1;
-                isWhite = !isWhite;
-                cur_cols_counters_offset[counterPosition] = i;
-            }
-        }
-        cur_cols_point_in_counters[i] = counterPosition;
-        i++;
-        rowBit += width;
-    }
-
-    cols_counter_offset_end[x] = counterPosition < end ? (counterPosition + 1) : end;
-
-    cols_counters_recorded[x] = true;
-    return;
-};
@@ -19,56 +19,89 @@ using namespace std;
 
 namespace zxing {
 
+// Pixels are stored either one per byte as 0 or 1, or bit-packed 64 to a word. The packed mode is
+// for binarized images, where flips, copies and run extraction work on whole words. The byte mode
+// is kept for the small sampled grids, which getPtr and getRowBoolPtr address directly and which
+// only exist in that mode.
 class BitMatrix : public Counted {
 public:
     static const int bitsPerWord = std::numeric_limits<unsigned int>::digits;
 
+    enum Storage { BYTE_PER_PIXEL, BIT_PACKED };
+
 private:
     int width;
     int height;
     int rowBitsSize;
+    Storage storage;
 
-    vector<COUNTER_TYPE> row_counters;
-    vector<COUNTER_TYPE> row_counters_offset;
-    vector<bool> row_counters_recorded;
-    vector<COUNTER_TYPE> row_counter_offset_end;
-    vector<COUNTER_TYPE> row_point_offset;
-
-    vector<COUNTER_TYPE> cols_counters;
-    vector<COUNTER_TYPE> cols_counters_offset;
-    vector<bool> cols_counters_recorded;
-    vector<COUNTER_TYPE> cols_counter_offset_end;
-    vector<COUNTER_TYPE> cols_point_offset;
+    // Runs of equal pixels of every row, row y owning entries row_run_begin[y] up to
+    // row_run_begin[y + 1] of the length and start arrays.
+    vector<int> row_run_begin;
+    vector<COUNTER_TYPE> row_run_lengths;
+    vector<COUNTER_TYPE> row_run_offsets;
 
     ArrayRef<unsigned char> bits;
     ArrayRef<int> rowOffsets;
 
+    // BIT_PACKED: pixel x of row y is bit x % 64 of words[y * rowWords + x / 64], with the bits
+    // past the width kept clear
+    vector<uint64_t> words;
+    int rowWords;
+
 public:
     BitMatrix(int _width, int _height, unsigned char* bitsPtr, ErrorHandler& err_handler);
     BitMatrix(int dimension, ErrorHandler& err_handler);
     BitMatrix(int _width, int _height, ErrorHandler& err_handler);
+    BitMatrix(int _width, int _height, Storage _storage, ErrorHandler& err_handler);
 
     void copyOf(Ref<BitMatrix> _bits, ErrorHandler& err_handler);
+    // copyOf followed by flipAll in a single pass
+    void invertedCopyOf(Ref<BitMatrix> _bits, ErrorHandler& err_handler);
     void xxor(Ref<BitMatrix> _bits);
 
     ~BitMatrix();
 
-    unsigned char get(int x, int y) const { return bits[width * y + x]; }
+    unsigned char get(int x, int y) const {
+        if (storage == BIT_PACKED) {
+            return (unsigned char)((words[(size_t)y * rowWords + (x >> 6)] >> (x & 63)) & 1);
+        }
+        return bits[width * y + x];
+    }
 
-    void set(int x, int y) { bits[rowOffsets[y] + x] = (unsigned char)1; }
+    void set(int x, int y) {
+        if (storage == BIT_PACKED) {
+            words[(size_t)y * rowWords + (x >> 6)] |= (uint64_t)1 << (x & 63);
+            return;
+        }
+        bits[rowOffsets[y] + x] = (unsigned char)1;
+    }
 
-    void set(int x, int y, unsigned char value) { bits[rowOffsets[y] + x] = value; }
+    void set(int x, int y, unsigned char value) {
+        if (storage == BIT_PACKED) {
+            uint64_t& word = words[(size_t)y * rowWords + (x >> 6)];
+            uint64_t mask = (uint64_t)1 << (x & 63);
+            word = value ? (word | mask) : (word & ~mask);
+            return;
+        }
+        bits[rowOffsets[y] + x] = value;
+    }
 
     void swap(int srcX, int srcY, int dstX, int dstY) {
-        auto temp = bits[width * srcY + srcX];
-        bits[width * srcY + srcX] = bits[width * dstY + dstX];
-        bits[width * dstY + dstX] = temp;
+        unsigned char temp = get(srcX, srcY);
+        set(srcX, srcY, get(dstX, dstY));
+        set(dstX, dstY, temp);
     }
 
+    Storage getStorage() const { return storage; }
+
+    // Row y as one 0-or-1 byte per pixel, in either mode
     void getRowBool(int y, bool* row);
-    bool* getRowBoolPtr(int y);
     void setRowBool(int y, bool* row);
+    void setRowBytes(int y, const unsigned char* row);
     int getRowBitsSize() { return rowBitsSize; }
+    // BYTE_PER_PIXEL only
+    bool* getRowBoolPtr(int y);
     unsigned char* getPtr() { return bits->data(); }
 
     void flip(int x, int y);
@@ -84,6 +117,8 @@ public:
     ArrayRef<int> getTopLeftOnBit() const;
     ArrayRef<int> getBottomRightOnBit() const;
 
+    // Run lengths and run starts of row y and their count, after initRowCounters. They stay
+    // valid until the matrix is copied into.
     bool isInitRowCounters;
     void initRowCounters();
     COUNTER_TYPE* getRowRecords(int y);
@@ -91,21 +126,15 @@ public:
     bool getRowFirstIsWhite(int y);
     COUNTER_TYPE getRowCounterOffsetEnd(int y);
     bool getRowLastIsWhite(int y);
-    COUNTER_TYPE* getRowPointInRecords(int y);
-
-    bool isInitColsCounters;
-    void initColsCounters();
-    COUNTER_TYPE* getColsRecords(int x);
-    COUNTER_TYPE* getColsRecordsOffset(int x);
-    COUNTER_TYPE* getColsPointInRecords(int x);
-    COUNTER_TYPE getColsCounterOffsetEnd(int x);
 
 private:
-    inline void init(int, int, ErrorHandler& err_handler);
+    inline void init(int, int, Storage, ErrorHandler& err_handler);
     inline void init(int _width, int _height, unsigned char* bitsPtr, ErrorHandler& err_handler);
 
-    void setRowRecords(int y);
-    void setColsRecords(int x);
+    void appendRowRuns(int y);
+    void appendPackedRowRuns(int y);
+    // storage for a copy of _bits, reusing the current one when the size and mode match
+    void resizeFor(Ref<BitMatrix> _bits, ErrorHandler& err_handler);
 
     BitMatrix(const BitMatrix&, ErrorHandler& err_handler);
 };
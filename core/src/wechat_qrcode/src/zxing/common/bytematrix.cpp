@@ -30,12 +30,12 @@ ByteMatrix::ByteMatrix(int dimension) : bytes(nullptr) { init(dimension, dimensi
 
 ByteMatrix::ByteMatrix(int _width, int _height) : bytes(nullptr) { init(_width, _height); }
 
-ByteMatrix::ByteMatrix(int _width, int _height, ArrayRef<char> source) : bytes(nullptr) {
+ByteMatrix::ByteMatrix(int _width, int _height, const ArrayRef<char>& source) : bytes(nullptr) {
     init(_width, _height);
 
     if( bytes != nullptr) {
         int size = _width * _height;
-        memcpy(&bytes[0], &source[0], size);
+        memcpy(&bytes[0], source.data(), size);
     }
 }
 
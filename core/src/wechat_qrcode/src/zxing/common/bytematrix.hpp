@@ -19,7 +19,7 @@ class ByteMatrix : public Counted {
 public:
     explicit ByteMatrix(int dimension);
     ByteMatrix(int _width, int _height);
-    ByteMatrix(int _width, int _height, ArrayRef<char> source);
+    ByteMatrix(int _width, int _height, const ArrayRef<char>& source);
     ~ByteMatrix();
 
     char get(int x, int y) const {
@@ -13,6 +13,7 @@
 
 #include <cstddef>
 #include <algorithm>
+#include "arena.hpp"
 namespace zxing {
 
 /* base class for reference-counted objects */
@@ -23,6 +24,11 @@ private:
 public:
     Counted() : count_(0) {}
     virtual ~Counted() {}
+
+    // from the thread's arena inside an ArenaScope, see arena.hpp
+    static void* operator new(size_t size) { return CountedArena::allocate(size); }
+    static void operator delete(void* ptr) { CountedArena::deallocate(ptr); }
+
     Counted* retain() {
         count_++;
         return this;
@@ -6,122 +6,194 @@
 // Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
 #include "../../precomp.hpp"
 #include "unicomblock.hpp"
+#include <algorithm>
 
 namespace zxing {
-short UnicomBlock::SEARCH_POS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 UnicomBlock::UnicomBlock(int iMaxHeight, int iMaxWidth)
-    : m_iHeight(iMaxHeight), m_iWidth(iMaxWidth), m_bInit(false) {}
+    : m_iHeight(iMaxHeight), m_iWidth(iMaxWidth), m_iNowIdx(0), m_bInit(false), m_iLabeledWidth(0) {}
 
 UnicomBlock::~UnicomBlock() {}
 
-void UnicomBlock::Init() {
-    if (m_bInit) return;
-    m_vcIndex = std::vector<unsigned int>(m_iHeight * m_iWidth, 0);
-    m_vcCount = std::vector<unsigned int>(m_iHeight * m_iWidth, 0);
-    m_vcMinPnt = std::vector<int>(m_iHeight * m_iWidth, 0);
-    m_vcMaxPnt = std::vector<int>(m_iHeight * m_iWidth, 0);
-    m_vcQueue = std::vector<int>(m_iHeight * m_iWidth, 0);
-    m_bInit = true;
+// The run buffers are sized when labeling, there is nothing to allocate ahead of it.
+void UnicomBlock::Init() {}
+
+void UnicomBlock::Resize(int iHeight, int iWidth) {
+    m_iHeight = iHeight;
+    m_iWidth = iWidth;
 }
 
 void UnicomBlock::Reset(Ref<BitMatrix> poImage) {
     m_poImage = poImage;
-    memset(&m_vcIndex[0], 0, m_vcIndex.size() * sizeof(m_vcIndex[0]));
+    m_bInit = false;
     m_iNowIdx = 0;
 }
 
 unsigned short UnicomBlock::GetUnicomBlockIndex(int y, int x) {
     if (y >= m_iHeight || x >= m_iWidth) return 0;
-    if (m_vcIndex[y * m_iWidth + x]) return m_vcIndex[y * m_iWidth + x];
-    Bfs(y, x);
-    return m_vcIndex[y * m_iWidth + x];
+    int iRoot = GetComponent(y, x);
+    if (iRoot < 0) return 0;
+    return m_vcIndex[iRoot];
 }
 
 int UnicomBlock::GetUnicomBlockSize(int y, int x) {
     if (y >= m_iHeight || x >= m_iWidth) return 0;
-    if (m_vcIndex[y * m_iWidth + x]) return m_vcCount[y * m_iWidth + x];
-    Bfs(y, x);
-    return m_vcCount[y * m_iWidth + x];
+    int iRoot = GetComponent(y, x);
+    if (iRoot < 0) return 0;
+    return m_vcCount[iRoot];
 }
 
 int UnicomBlock::GetMinPoint(int y, int x, int &iMinY, int &iMinX) {
     if (y >= m_iHeight || x >= m_iWidth) return -1;
-    if (m_vcIndex[y * m_iWidth + x]) {
-        iMinY = m_vcMinPnt[y * m_iWidth + x] >> 16;
-        iMinX = m_vcMinPnt[y * m_iWidth + x] & (0xFFFF);
-        return 0;
-    }
-    Bfs(y, x);
-    iMinY = m_vcMinPnt[y * m_iWidth + x] >> 16;
-    iMinX = m_vcMinPnt[y * m_iWidth + x] & (0xFFFF);
+    int iRoot = GetComponent(y, x);
+    if (iRoot < 0) return -1;
+    iMinY = m_vcMinPnt[iRoot] >> 16;
+    iMinX = m_vcMinPnt[iRoot] & (0xFFFF);
     return 0;
 }
 
 int UnicomBlock::GetMaxPoint(int y, int x, int &iMaxY, int &iMaxX) {
     if (y >= m_iHeight || x >= m_iWidth) return -1;
-    if (m_vcIndex[y * m_iWidth + x]) {
-        iMaxY = m_vcMaxPnt[y * m_iWidth + x] >> 16;
-        iMaxX = m_vcMaxPnt[y * m_iWidth + x] & (0xFFFF);
-        return 0;
-    }
-    Bfs(y, x);
-    iMaxY = m_vcMaxPnt[y * m_iWidth + x] >> 16;
-    iMaxX = m_vcMaxPnt[y * m_iWidth + x] & (0xFFFF);
+    int iRoot = GetComponent(y, x);
+    if (iRoot < 0) return -1;
+    iMaxY = m_vcMaxPnt[iRoot] >> 16;
+    iMaxX = m_vcMaxPnt[iRoot] & (0xFFFF);
     return 0;
 }
 
-void UnicomBlock::Bfs(int y, int x) {
-    m_iNowIdx++;
-
-    int iFront = 0;
-    int iTail = 0;
-    int iCount = 1;
-
-    int iMaxX = x, iMaxY = y;
-    int iMinX = x, iMinY = y;
+int UnicomBlock::GetComponent(int y, int x) {
+    if (!m_bInit) Label();
+    if (y < 0 || x < 0 || y >= int(m_vcRowBegin.size()) - 1 || x >= m_iLabeledWidth) return -1;
 
-    const bool bValue = (m_poImage->get(x, y) != (unsigned char)0);
+    // the last run of the row starting at or before x
+    const int *pRowStart = m_vcRunStart.data() + m_vcRowBegin[y];
+    const int *pRowEnd = m_vcRunStart.data() + m_vcRowBegin[y + 1];
+    int iRun = int(std::upper_bound(pRowStart, pRowEnd, x) - m_vcRunStart.data()) - 1;
 
-    m_vcIndex[y * m_iWidth + x] = m_iNowIdx;
-    m_vcQueue[iTail++] = y << 16 | x;
-
-    while (iFront < iTail) {
-        int iNode = m_vcQueue[iFront++];
-        int iX = iNode & (0xFFFF);
-        int iY = iNode >> 16;
-        iMaxX = max(iX, iMaxX);
-        iMaxY = max(iY, iMaxY);
-        iMinX = min(iX, iMinX);
-        iMinY = min(iY, iMinY);
+    int iRoot = m_vcParent[iRun];
+    if (!m_vcIndex[iRoot]) m_vcIndex[iRoot] = ++m_iNowIdx;
+    return iRoot;
+}
 
-        iCount++;
+int UnicomBlock::FindRoot(int iRun) {
+    while (m_vcParent[iRun] != iRun) {
+        m_vcParent[iRun] = m_vcParent[m_vcParent[iRun]];
+        iRun = m_vcParent[iRun];
+    }
+    return iRun;
+}
 
-        for (int i = 0; i < 4; ++i) {
-            const int iNextX = iX + SEARCH_POS[i][0], iNextY = iY + SEARCH_POS[i][1];
-            const int iPosition = iNextY * m_iWidth + iNextX;
+bool UnicomBlock::SameComponentsAsLabeled() {
+    const int iHeight = m_poImage->getHeight();
+    if (int(m_vcRowBegin.size()) != iHeight + 1 || m_iLabeledWidth != m_poImage->getWidth()) return false;
+
+    // Equal runs with every row starting on the same color, or every row on the other one as in
+    // the inverted matrix, give the same components.
+    int iFlipped = -1;
+    for (int y = 0; y < iHeight; ++y) {
+        const int iBegin = m_vcRowBegin[y];
+        const int iCount = m_poImage->getRowCounterOffsetEnd(y);
+        if (iCount != m_vcRowBegin[y + 1] - iBegin) return false;
+        const COUNTER_TYPE *pLengths = m_poImage->getRowRecords(y);
+        for (int i = 0; i < iCount; ++i) {
+            if (pLengths[i] != m_vcRunLength[iBegin + i]) return false;
+        }
+        const int iRowFlipped = (m_poImage->get(0, y) != 0) != (m_vcRowFirst[y] != 0);
+        if (iFlipped < 0) {
+            iFlipped = iRowFlipped;
+        } else if (iRowFlipped != iFlipped) {
+            return false;
+        }
+    }
+    if (iFlipped > 0) {
+        for (auto &first : m_vcRowFirst) first ^= 1;
+    }
+    return true;
+}
 
-            if (iPosition >= 0 && iPosition < int(m_vcIndex.size()) && 0 == m_vcIndex[iPosition]) {
-                if (iNextX < 0 || iNextX >= m_poImage->getWidth() || iNextY < 0 ||
-                    iNextY >= m_poImage->getHeight() ||
-                    bValue != (m_poImage->get(iNextX, iNextY) != (unsigned char)0))
-                    continue;
+void UnicomBlock::Label() {
+    m_bInit = true;
+    m_poImage->initRowCounters();
+    if (SameComponentsAsLabeled()) {
+        // only the indices start over
+        std::fill(m_vcIndex.begin(), m_vcIndex.end(), 0);
+        return;
+    }
 
-                m_vcIndex[iPosition] = m_iNowIdx;
-                m_vcQueue[iTail++] = iNextY << 16 | iNextX;
+    const int iHeight = m_poImage->getHeight();
+    m_iLabeledWidth = m_poImage->getWidth();
+    m_vcRowBegin.resize(iHeight + 1);
+    m_vcRowFirst.resize(iHeight);
+    m_vcRunStart.clear();
+    m_vcRunLength.clear();
+    for (int y = 0; y < iHeight; ++y) {
+        m_vcRowBegin[y] = int(m_vcRunStart.size());
+        m_vcRowFirst[y] = m_poImage->get(0, y) != 0;
+        const int iCount = m_poImage->getRowCounterOffsetEnd(y);
+        const COUNTER_TYPE *pLengths = m_poImage->getRowRecords(y);
+        const COUNTER_TYPE *pOffsets = m_poImage->getRowRecordsOffset(y);
+        for (int i = 0; i < iCount; ++i) {
+            m_vcRunStart.push_back(pOffsets[i]);
+            m_vcRunLength.push_back(pLengths[i]);
+        }
+    }
+    const int iRuns = int(m_vcRunStart.size());
+    m_vcRowBegin[iHeight] = iRuns;
+
+    // Runs alternate in color along a row, so only runs of the row above can join a run: those of
+    // the same color sharing a column with it. The root of a component is its first run.
+    m_vcParent.resize(iRuns);
+    for (int i = 0; i < iRuns; ++i) m_vcParent[i] = i;
+    for (int y = 1; y < iHeight; ++y) {
+        int a = m_vcRowBegin[y - 1], b = m_vcRowBegin[y];
+        const int aEnd = m_vcRowBegin[y], bEnd = m_vcRowBegin[y + 1];
+        while (a < aEnd && b < bEnd) {
+            const int aStop = m_vcRunStart[a] + m_vcRunLength[a];
+            const int bStop = m_vcRunStart[b] + m_vcRunLength[b];
+            const bool aValue = m_vcRowFirst[y - 1] ^ ((a - m_vcRowBegin[y - 1]) & 1);
+            const bool bValue = m_vcRowFirst[y] ^ ((b - m_vcRowBegin[y]) & 1);
+            if (aValue == bValue && m_vcRunStart[a] < bStop && m_vcRunStart[b] < aStop) {
+                const int aRoot = FindRoot(a), bRoot = FindRoot(b);
+                if (aRoot < bRoot) {
+                    m_vcParent[bRoot] = aRoot;
+                } else if (bRoot < aRoot) {
+                    m_vcParent[aRoot] = bRoot;
+                }
             }
+            if (aStop <= bStop) a++;
+            if (bStop <= aStop) b++;
         }
     }
 
-    if (iCount >= (1 << 16) - 1) iCount = 0xFFFF;
-
-    const int iMinCombine = iMinY << 16 | iMinX;
-    const int iMaxCombine = iMaxY << 16 | iMaxX;
-    for (int i = 0; i < iTail; ++i) {
-        const int iPosition = (m_vcQueue[i] >> 16) * m_iWidth + (m_vcQueue[i] & (0xFFFF));
-
-        m_vcCount[iPosition] = iCount;
-        m_vcMinPnt[iPosition] = iMinCombine;
-        m_vcMaxPnt[iPosition] = iMaxCombine;
+    // Sizes and bounding boxes per root, visited before the rest of its component. The size
+    // counts one more than the pixels, as it always has.
+    m_vcIndex.assign(iRuns, 0);
+    m_vcCount.assign(iRuns, 0);
+    m_vcMinPnt.resize(iRuns);
+    m_vcMaxPnt.resize(iRuns);
+    std::vector<int> vcMinX(iRuns), vcMaxX(iRuns), vcMinY(iRuns), vcMaxY(iRuns);
+    for (int y = 0; y < iHeight; ++y) {
+        for (int i = m_vcRowBegin[y]; i < m_vcRowBegin[y + 1]; ++i) {
+            const int iRoot = FindRoot(i);
+            m_vcParent[i] = iRoot;
+            const int iStart = m_vcRunStart[i];
+            const int iStop = iStart + m_vcRunLength[i] - 1;
+            if (m_vcCount[iRoot] == 0) {
+                vcMinX[iRoot] = iStart;
+                vcMaxX[iRoot] = iStop;
+                vcMinY[iRoot] = y;
+            } else {
+                vcMinX[iRoot] = min(vcMinX[iRoot], iStart);
+                vcMaxX[iRoot] = max(vcMaxX[iRoot], iStop);
+            }
+            vcMaxY[iRoot] = y;
+            m_vcCount[iRoot] += m_vcRunLength[i];
+        }
+    }
+    for (int i = 0; i < iRuns; ++i) {
+        if (m_vcParent[i] != i) continue;
+        m_vcCount[i] = min(m_vcCount[i] + 1, 0xFFFF);
+        m_vcMinPnt[i] = vcMinY[i] << 16 | vcMinX[i];
+        m_vcMaxPnt[i] = vcMaxY[i] << 16 | vcMaxX[i];
     }
 }
 }  // namespace zxing
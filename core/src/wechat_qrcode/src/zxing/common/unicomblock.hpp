@@ -11,6 +11,10 @@
 #include "counted.hpp"
 
 namespace zxing {
+// Connected components of equal pixels (4-connected) of a BitMatrix. Components are labeled with
+// a union-find over the row runs of the matrix the first time one is queried after Reset, so the
+// buffers grow with the number of runs rather than pixels. Indices are handed out in the order
+// components are first queried, starting at 1 after every Reset.
 class UnicomBlock : public Counted {
 public:
     UnicomBlock(int iMaxHeight, int iMaxWidth);
@@ -18,6 +22,10 @@ public:
 
     void Init();
     void Reset(Ref<BitMatrix> poImage);
+    // Drop the image of the last Reset, so that a block kept across decodes does not hold on to it
+    void ReleaseImage() { Reset(Ref<BitMatrix>()); }
+    // Reuse the buffers for an image of another size, they only grow
+    void Resize(int iHeight, int iWidth);
 
     unsigned short GetUnicomBlockIndex(int y, int x);
 
@@ -27,19 +35,30 @@ public:
     int GetMaxPoint(int y, int x, int &iMaxY, int &iMaxX);
 
 private:
-    void Bfs(int y, int x);
+    void Label();
+    bool SameComponentsAsLabeled();
+    int FindRoot(int iRun);
+    // the labeled component holding pixel (y, x), first queried components get the next index
+    int GetComponent(int y, int x);
 
     int m_iHeight;
     int m_iWidth;
 
     unsigned int m_iNowIdx;
-    bool m_bInit;
+    bool m_bInit;  // m_poImage is labeled
+
+    // runs of the labeled matrix, those of row y from m_vcRowBegin[y] up to m_vcRowBegin[y + 1]
+    int m_iLabeledWidth;
+    std::vector<int> m_vcRowBegin;
+    std::vector<int> m_vcRunStart;
+    std::vector<int> m_vcRunLength;
+    std::vector<unsigned char> m_vcRowFirst;
+    // component root of every run, and per root its index, size and corners
+    std::vector<int> m_vcParent;
     std::vector<unsigned int> m_vcIndex;
-    std::vector<unsigned int> m_vcCount;
+    std::vector<int> m_vcCount;
     std::vector<int> m_vcMinPnt;
     std::vector<int> m_vcMaxPnt;
-    std::vector<int> m_vcQueue;
-    static short SEARCH_POS[4][2];
 
     Ref<BitMatrix> m_poImage;
 };
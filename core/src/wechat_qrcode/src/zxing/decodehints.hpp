@@ -13,16 +13,32 @@
 
 #include "errorhandler.hpp"
 
+namespace cv {
+namespace wechat_qrcode {
+class DecodeControl;
+}  // namespace wechat_qrcode
+}  // namespace cv
+
 namespace zxing {
 class DecodeHints {
 private:
     bool use_nn_detector_;
+    cv::wechat_qrcode::DecodeControl* control_ = nullptr;
+    int max_results_ = 0;
 
 public:
     explicit DecodeHints(bool use_nn_detector = false) : use_nn_detector_(use_nn_detector){};
 
     bool getUseNNDetector() const { return use_nn_detector_; }
     void setUseNNDetector(bool use_nn_detector) { use_nn_detector_ = use_nn_detector; }
+
+    // Time budget and cancellation of the current call, may be null.
+    cv::wechat_qrcode::DecodeControl* getControl() const { return control_; }
+    void setControl(cv::wechat_qrcode::DecodeControl* control) { control_ = control; }
+
+    // Stop combining finder patterns once this many codes are decoded, 0 for no limit.
+    int getMaxResults() const { return max_results_; }
+    void setMaxResults(int max_results) { max_results_ = max_results; }
 };
 
 }  // namespace zxing
@@ -781,27 +781,19 @@ float FinderPatternFinder::crossCheckVertical(size_t startI, size_t centerJ, int
     // This is slightly faster than using the Ref. Efficiency is important here
     BitMatrix& matrix = *image_;
 
-    bool* imageRow0 = matrix.getRowBoolPtr(0);
-    bool* p = imageRow0;
-    int imgWidth = matrix.getWidth();
-
     // Start counting up from center
     int ii = startI;
 
-    p = imageRow0 + ii * imgWidth + centerJ;
-
-    while (ii >= 0 && *p) {
+    while (ii >= 0 && matrix.get(centerJ, ii)) {
         stateCount[2]++;
         ii--;
-        p -= imgWidth;
     }
     if (ii < 0) {
         return nan();
     }
-    while (ii >= 0 && !*p && stateCount[1] <= maxCount) {
+    while (ii >= 0 && !matrix.get(centerJ, ii) && stateCount[1] <= maxCount) {
         stateCount[1]++;
         ii--;
-        p -= imgWidth;
     }
     // If already too many modules in this state or ran off the edge:
     if (ii < 0 || stateCount[1] > maxCount) {
@@ -810,10 +802,9 @@ float FinderPatternFinder::crossCheckVertical(size_t startI, size_t centerJ, int
 
     CrossCheckState tmpCheckState = FinderPatternFinder::NORMAL;
 
-    while (ii >= 0 && *p /*&& stateCount[0] <= maxCount*/) {  // n:1:3:1:1
+    while (ii >= 0 && matrix.get(centerJ, ii) /*&& stateCount[0] <= maxCount*/) {  // n:1:3:1:1
         stateCount[0]++;
         ii--;
-        p -= imgWidth;
     }
 
     if (stateCount[0] >= maxCount) {
@@ -823,44 +814,33 @@ float FinderPatternFinder::crossCheckVertical(size_t startI, size_t centerJ, int
     // Now also count down from center
     ii = startI + 1;
 
-    p = imageRow0 + ii * imgWidth + centerJ;
-
-    while (ii < maxI && *p) {  // 1:1:"3":1:1
-                               // while (ii < maxI && matrix.get(centerJ, ii)) {
+    while (ii < maxI && matrix.get(centerJ, ii)) {  // 1:1:"3":1:1
         stateCount[2]++;
         ii++;
-
-        p += imgWidth;
     }
     if (ii == maxI) {
         return nan();
     }
-    while (ii < maxI && !*p && stateCount[3] < maxCount) {  // 1:1:3:"1":1
+    while (ii < maxI && !matrix.get(centerJ, ii) && stateCount[3] < maxCount) {  // 1:1:3:"1":1
         stateCount[3]++;
         ii++;
-
-        p += imgWidth;
     }
     if (ii == maxI || stateCount[3] >= maxCount) {
         return nan();
     }
 
     if (tmpCheckState == FinderPatternFinder::LEFT_SPILL) {
-        while (ii < maxI && *p && stateCount[4] < maxCount) {  // 1:1:3:1:"1"
+        while (ii < maxI && matrix.get(centerJ, ii) && stateCount[4] < maxCount) {  // 1:1:3:1:"1"
             stateCount[4]++;
             ii++;
-
-            p += imgWidth;
         }
         if (stateCount[4] >= maxCount) {
             return nan();
         }
     } else {  // 1:1:3:1:"n"
-        while (ii < maxI && *p) {
+        while (ii < maxI && matrix.get(centerJ, ii)) {
             stateCount[4]++;
             ii++;
-
-            p += imgWidth;
         }
         if (stateCount[4] >= maxCount) {
             tmpCheckState = FinderPatternFinder::RIHGT_SPILL;
@@ -915,19 +895,14 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
     BitMatrix& matrix = *image_;
     int j = startJ;
 
-    bool* centerIrow = NULL;
-
-    centerIrow = matrix.getRowBoolPtr(centerI);
-
-    //	while (j >= 0 &&matrix.get(j, centerI)) {
-    while (j >= 0 && centerIrow[j]) {
+    while (j >= 0 && matrix.get(j, centerI)) {
         stateCount[2]++;
         j--;
     }
     if (j < 0) {
         return nan();
     }
-    while (j >= 0 && !centerIrow[j] && stateCount[1] <= maxCount) {
+    while (j >= 0 && !matrix.get(j, centerI) && stateCount[1] <= maxCount) {
         stateCount[1]++;
         j--;
     }
@@ -936,7 +911,7 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
     }
     CrossCheckState tmpCheckState = FinderPatternFinder::NORMAL;
 
-    while (j >= 0 && centerIrow[j] /* && stateCount[0] <= maxCount*/) {
+    while (j >= 0 && matrix.get(j, centerI) /* && stateCount[0] <= maxCount*/) {
         stateCount[0]++;
         j--;
     }
@@ -945,14 +920,14 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
     }
 
     j = startJ + 1;
-    while (j < maxJ && centerIrow[j]) {
+    while (j < maxJ && matrix.get(j, centerI)) {
         stateCount[2]++;
         j++;
     }
     if (j == maxJ) {
         return nan();
     }
-    while (j < maxJ && !centerIrow[j] && stateCount[3] < maxCount) {
+    while (j < maxJ && !matrix.get(j, centerI) && stateCount[3] < maxCount) {
         stateCount[3]++;
         j++;
     }
@@ -961,7 +936,7 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
     }
 
     if (tmpCheckState == LEFT_SPILL) {
-        while (j < maxJ && centerIrow[j] && stateCount[4] <= maxCount) {
+        while (j < maxJ && matrix.get(j, centerI) && stateCount[4] <= maxCount) {
             stateCount[4]++;
             j++;
         }
@@ -969,7 +944,7 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
             return nan();
         }
     } else {
-        while (j < maxJ && centerIrow[j]) {
+        while (j < maxJ && matrix.get(j, centerI)) {
             stateCount[4]++;
             j++;
         }
@@ -978,7 +953,7 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
         }
     }
 
-    while (j < maxJ && centerIrow[j] /*&& stateCount[4] < maxCount*/) {
+    while (j < maxJ && matrix.get(j, centerI) /*&& stateCount[4] < maxCount*/) {
         stateCount[4]++;
         j++;
     }
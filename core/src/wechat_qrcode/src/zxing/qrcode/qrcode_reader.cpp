@@ -12,6 +12,8 @@
 #include <ctime>
 #include "../common/bitarray.hpp"
 #include "detector/detector.hpp"
+#include "../../stats_timer.hpp"
+#include "opencv2/wechat_qrcode.hpp"
 
 
 using zxing::ErrorHandler;
@@ -34,6 +36,16 @@ QRCodeReader::QRCodeReader() : decoder_() {
     smoothMaxMultiple_ = 40;
 }
 
+namespace {
+bool shouldStop(const DecodeHints &hints) {
+    return hints.getControl() != nullptr && hints.getControl()->shouldStop();
+}
+
+bool hasEnoughResults(const DecodeHints &hints, const vector<Ref<Result>> &result_list) {
+    return hints.getMaxResults() > 0 && static_cast<int>(result_list.size()) >= hints.getMaxResults();
+}
+}  // namespace
+
 vector<Ref<Result>> QRCodeReader::decode(Ref<BinaryBitmap> image) { return decode(image, DecodeHints()); }
 
 vector<Ref<Result>> QRCodeReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
@@ -44,15 +56,19 @@ vector<Ref<Result>> QRCodeReader::decode(Ref<BinaryBitmap> image, DecodeHints hi
     if (err_handler.ErrCode() || imageBitMatrix == NULL) return result_list;
 
     vector<Ref<Result>> rst = decodeMore(image, imageBitMatrix, hints, err_handler);
-    if (err_handler.ErrCode() || rst.empty()) {
+    if ((err_handler.ErrCode() || rst.empty()) && !shouldStop(hints)) {
         // black white mirro!!!
+        rst.clear();
         Ref<BitMatrix> invertedMatrix = image->getInvertedMatrix(err_handler);
-        if (err_handler.ErrCode() || invertedMatrix == NULL) return result_list;
-        vector<Ref<Result>> tmp_rst = decodeMore(image, invertedMatrix, hints, err_handler);
-        if (err_handler.ErrCode() || tmp_rst.empty()) return result_list;
-        return tmp_rst;
+        if (!err_handler.ErrCode() && invertedMatrix != NULL) {
+            rst = decodeMore(image, invertedMatrix, hints, err_handler);
+            if (err_handler.ErrCode()) rst.clear();
+        }
     }
 
+    // The detect info describes this call only. Dropping its border points here keeps a reader that lives across
+    // calls from holding on to objects of the caller's arena scope.
+    possibleQrcodeInfo_.clear();
     return rst;
 }
 
@@ -65,11 +81,14 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
     image->m_poUnicomBlock->Init();
     image->m_poUnicomBlock->Reset(imageBitMatrix);
 
+    cv::wechat_qrcode::StatsTimer timer(collectTimes_);
     for (int tryTimes = 0; tryTimes < 1; tryTimes++) {
         Ref<Detector> detector(new Detector(imageBitMatrix, image->m_poUnicomBlock));
         err_handler.Reset();
 
+        timer.lap();
         detector->detect(hints, err_handler);
+        finderTime_ += timer.lap();
         if (err_handler.ErrCode()) {
             err_handler = zxing::ReaderErrorHandler("error detect");
             setReaderState(detector->getState());
@@ -85,6 +104,7 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
             continue;
         }
         for (int i = 0; i < possiblePatternCount; i++) {
+            if (shouldStop(hints)) break;
             // filter and perserve the highest score.
             Ref<FinderPatternInfo> patternInfo = detector->getFinderPatternInfo(i);
 
@@ -109,8 +129,10 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                 Ref<AlignmentPattern> alignmentPattern = detector->getAlignmentPattern(i, j);
                 ArrayRef<Ref<ResultPoint> > points;
                 err_handler.Reset();
+                timer.lap();
                 Ref<DetectorResult> detectorResult =
                     detector->getResultViaAlignment(i, j, detectedDimension_, err_handler);
+                finderTime_ += timer.lap();
                 if (err_handler.ErrCode()) {
                     ept = err_handler.ErrCode();
                     setDecoderFix(decoder_.getPossibleFix(), points);
@@ -125,6 +147,7 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                 points = detectorResult->getPoints();
                 Ref<DecoderResult> decoderResult(
                     decoder_.decode(detectorResult->getBits(), err_handler));
+                decoderTime_ += timer.lap();
                 if (err_handler.ErrCode()) {
                     ept = err_handler.ErrCode();
                     setDecoderFix(decoder_.getPossibleFix(), points);
@@ -165,7 +188,7 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                 setSuccFix(points);
                 result_list.push_back(result);
                 patternFoundFlag = true;
-                if (nowHints_.getUseNNDetector()) {
+                if (nowHints_.getUseNNDetector() || hasEnoughResults(nowHints_, result_list)) {
                     return result_list;
                 }
             }
@@ -178,11 +201,14 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                 if (needTryVariousDeimensions[j]) {
                     vector<int> possibleDimensions = getPossibleDimentions(detectedDimension_);
                     for (size_t k = 1; k < possibleDimensions.size(); k++) {
+                        if (shouldStop(hints)) break;
                         err_handler.Reset();
                         int dimension = possibleDimensions[k];
 
+                        timer.lap();
                         Ref<DetectorResult> detectorResult =
                             detector->getResultViaAlignment(i, j, dimension, err_handler);
+                        finderTime_ += timer.lap();
                         if (err_handler.ErrCode() || detectorResult == NULL) {
                             ept = err_handler.ErrMsg();
                             setDecoderFix(decoder_.getPossibleFix(), points);
@@ -193,6 +219,7 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                         points = detectorResult->getPoints();
                         Ref<DecoderResult> decoderResult(
                             decoder_.decode(detectorResult->getBits(), err_handler));
+                        decoderTime_ += timer.lap();
                         if (err_handler.ErrCode() || decoderResult == NULL) {
                             ept = err_handler.ErrMsg();
                             setDecoderFix(decoder_.getPossibleFix(), points);
@@ -229,7 +256,7 @@ vector<Ref<Result>> QRCodeReader::decodeMore(Ref<BinaryBitmap> image, Ref<BitMat
                         setSuccFix(points);
                         result_list.push_back(result);
                         patternFoundFlag = true;
-                        if (nowHints_.getUseNNDetector()) {
+                        if (nowHints_.getUseNNDetector() || hasEnoughResults(nowHints_, result_list)) {
                             return result_list;
                         }
                     }
@@ -299,9 +326,7 @@ int QRCodeReader::smooth(unsigned int *integral, Ref<BitMatrix> input, Ref<BitMa
 
     bool *jrowtoset = new bool[bitsize];
 
-    bool *jrow = NULL;
-
-    jrow = NULL;
+    bool *jrow = new bool[bitsize];
 
     unsigned int size = window * window;
 
@@ -312,7 +337,7 @@ int QRCodeReader::smooth(unsigned int *integral, Ref<BitMatrix> input, Ref<BitMa
         int offset1 = y1 * width;
         int offset2 = y2 * width;
 
-        jrow = imatrix.getRowBoolPtr(j);
+        imatrix.getRowBool(j, jrow);
 
         memcpy(jrowtoset, jrow, bitsize * sizeof(bool));
 
@@ -343,6 +368,7 @@ int QRCodeReader::smooth(unsigned int *integral, Ref<BitMatrix> input, Ref<BitMa
     }
 
     delete[] jrowtoset;
+    delete[] jrow;
     return count;
 }
 
@@ -351,9 +377,9 @@ void QRCodeReader::initIntegralOld(unsigned int *integral, Ref<BitMatrix> input)
     int width = input->getWidth();
     int height = input->getHeight();
 
-    bool *therow = NULL;
+    bool *therow = new bool[width];
 
-    therow = matrix.getRowBoolPtr(0);
+    matrix.getRowBool(0, therow);
 
     integral[0] = therow[0];
 
@@ -372,7 +398,7 @@ void QRCodeReader::initIntegralOld(unsigned int *integral, Ref<BitMatrix> input)
 
     for (int i = 1; i < height; i++) {
         offset = i * width;
-        therow = matrix.getRowBoolPtr(i);
+        matrix.getRowBool(i, therow);
 
         integral[offset] = integral[offset - width] + therow[0];
         offset++;
@@ -386,6 +412,7 @@ void QRCodeReader::initIntegralOld(unsigned int *integral, Ref<BitMatrix> input)
     }
 
     delete[] s;
+    delete[] therow;
 
     return;
 }
@@ -395,9 +422,9 @@ void QRCodeReader::initIntegral(unsigned int *integral, Ref<BitMatrix> input) {
     int width = input->getWidth();
     int height = input->getHeight();
 
-    bool *therow = NULL;
+    bool *therow = new bool[width];
 
-    therow = matrix.getRowBoolPtr(0);
+    matrix.getRowBool(0, therow);
 
     // first row only
     int rs = 0;
@@ -410,7 +437,7 @@ void QRCodeReader::initIntegral(unsigned int *integral, Ref<BitMatrix> input) {
     int offset = 0;
 
     for (int i = 1; i < height; ++i) {
-        therow = matrix.getRowBoolPtr(i);
+        matrix.getRowBool(i, therow);
 
         rs = 0;
 
@@ -422,6 +449,7 @@ void QRCodeReader::initIntegral(unsigned int *integral, Ref<BitMatrix> input) {
         }
     }
 
+    delete[] therow;
     return;
 }
 
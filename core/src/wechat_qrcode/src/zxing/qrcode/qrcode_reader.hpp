@@ -118,6 +118,23 @@ public:
     void setSuccFix(ArrayRef<Ref<ResultPoint> > border);
 
     ReaderState getReaderState() { return this->readerState_; }
+
+    // Accumulated finder (detection and sampling) and decoder time in milliseconds, only
+    // measured after setCollectTimes(true). setCollectTimes also restarts the accumulation.
+    void setCollectTimes(bool collect) {
+        collectTimes_ = collect;
+        finderTime_ = 0;
+        decoderTime_ = 0;
+    }
+    double getFinderTime() const { return finderTime_; }
+    double getDecoderTime() const { return decoderTime_; }
+
+private:
+    bool collectTimes_ = false;
+    double finderTime_ = 0;
+    double decoderTime_ = 0;
+
+public:
     float calQrcodeArea(Ref<DetectorResult> detectorResult);
     float calTriangleArea(Ref<ResultPoint> centerA, Ref<ResultPoint> centerB,
                           Ref<ResultPoint> centerC);
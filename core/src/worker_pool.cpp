@@ -0,0 +1,156 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace zzt::qrcode {
+WorkerPool &WorkerPool::instance() {
+    static WorkerPool pool;
+    return pool;
+}
+
+// The pool this thread works for, null on threads that are not a worker of any pool.
+static thread_local const WorkerPool *current_pool = nullptr;
+
+WorkerPool::~WorkerPool() {
+    stop();
+    // No thread is left to run the tasks still queued at exit, tell their waiters instead.
+    for (auto &task : tasks) {
+        if (task.drop) {
+            task.drop();
+        }
+    }
+    tasks.clear();
+}
+
+static int resolve_thread_count(int count) {
+    if (count > 0) {
+        return count;
+    }
+    return static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+}
+
+bool WorkerPool::set_thread_count(int count) {
+    if (is_worker_thread()) {
+        return false;
+    }
+    std::lock_guard resize_guard(resize_mutex);
+    bool running = !threads.empty();
+    stop();
+    thread_count = std::max(count, 0);
+    if (running) {
+        start(resolve_thread_count(thread_count));
+    }
+    return true;
+}
+
+int WorkerPool::get_thread_count() {
+    std::lock_guard resize_guard(resize_mutex);
+    return resolve_thread_count(thread_count);
+}
+
+void WorkerPool::submit(std::function<void()> task, std::function<void()> drop) {
+    {
+        std::lock_guard resize_guard(resize_mutex);
+        if (threads.empty()) {
+            start(resolve_thread_count(thread_count));
+        }
+    }
+    {
+        std::lock_guard g(mutex);
+        tasks.push_back({std::move(task), std::move(drop)});
+    }
+    cond.notify_one();
+}
+
+void WorkerPool::parallel_for(int count, int concurrency, const std::function<void(int)> &body) {
+    if (count <= 0) {
+        return;
+    }
+    if (concurrency <= 0) {
+        concurrency = get_thread_count() + 1;
+    }
+    int helper_count = std::min(concurrency, count) - 1;
+    if (helper_count <= 0) {
+        for (int i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Helpers that only start after every index is taken return without touching body, so the state is shared
+    // and outlives this call while body does not need to.
+    struct State {
+        std::atomic<int> next{0};
+        std::mutex mutex;
+        std::condition_variable cond;
+        int running = 0;
+    };
+    auto state = std::make_shared<State>();
+    auto drain = [count, &body](State &s) {
+        for (int i = s.next++; i < count; i = s.next++) {
+            body(i);
+        }
+    };
+    for (int i = 0; i < helper_count; ++i) {
+        submit([state, drain] {
+            {
+                std::lock_guard g(state->mutex);
+                state->running++;
+            }
+            drain(*state);
+            {
+                std::lock_guard g(state->mutex);
+                state->running--;
+            }
+            state->cond.notify_all();
+        });
+    }
+    drain(*state);
+    std::unique_lock g(state->mutex);
+    state->cond.wait(g, [&] { return state->running == 0; });
+}
+
+bool WorkerPool::is_worker_thread() const { return current_pool == this; }
+
+void WorkerPool::start(int count) {
+    std::lock_guard g(mutex);
+    stopping = false;
+    threads.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        threads.emplace_back(&WorkerPool::worker_loop, this);
+    }
+}
+
+void WorkerPool::stop() {
+    std::vector<std::thread> old_threads;
+    {
+        std::lock_guard g(mutex);
+        stopping = true;
+        old_threads.swap(threads);
+    }
+    cond.notify_all();
+    for (auto &t : old_threads) {
+        t.join();
+    }
+}
+
+void WorkerPool::worker_loop() {
+    current_pool = this;
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock g(mutex);
+            cond.wait(g, [this] { return stopping || !tasks.empty(); });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks.front().run);
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+}  // namespace zzt::qrcode
@@ -0,0 +1,70 @@
+#ifndef ZZT_WORKER_POOL_H
+#define ZZT_WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zzt::qrcode {
+/**
+ * Process-wide pool of worker threads used by the asynchronous decode API.
+ * Threads are started lazily on the first submitted task.
+ */
+class WorkerPool {
+public:
+    static WorkerPool &instance();
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * Change the number of worker threads, 0 means one thread per hardware core.
+     * Pending tasks are kept and picked up by the new threads.
+     * @return false if called from one of the pool's own threads.
+     */
+    bool set_thread_count(int count);
+    int get_thread_count();
+
+    /**
+     * Queue task. drop runs instead when the pool shuts down before a thread took the task, so whoever waits for
+     * it learns that it never ran.
+     */
+    void submit(std::function<void()> task, std::function<void()> drop = nullptr);
+
+    /**
+     * Run body(i) for every i in [0, count) on up to concurrency threads, the calling thread included, and return
+     * once all are done. The caller takes indices as well, so this never waits on a busy pool and may be called
+     * from a worker thread. concurrency 0 means one thread per pool thread plus the caller.
+     */
+    void parallel_for(int count, int concurrency, const std::function<void(int)> &body);
+
+    bool is_worker_thread() const;
+
+private:
+    WorkerPool() = default;
+
+    void start(int count);
+    void stop();
+    void worker_loop();
+
+    struct Task {
+        std::function<void()> run;
+        std::function<void()> drop;
+    };
+
+    std::mutex resize_mutex;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<Task> tasks;
+    std::vector<std::thread> threads;
+    int thread_count = 0;
+    bool stopping = false;
+};
+}  // namespace zzt::qrcode
+
+#endif  // ZZT_WORKER_POOL_H
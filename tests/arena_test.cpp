@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/decodermgr.hpp"
+#include "wechat_qrcode/src/zxing/common/arena.hpp"
+#include "wechat_qrcode/src/zxing/resultpoint.hpp"
+
+// The arena chunk of a thread only starts over when nothing carved from it is alive as its outermost scope closes.
+// A pooled DecoderMgr lives across decodes, so neither it nor its results may keep zxing objects of an attempt: after
+// every decode, successful or not, serial or through parallel_for, the chunk has started over.
+
+using cv::Point2f;
+using cv::wechat_qrcode::DecoderMgr;
+using cv::wechat_qrcode::ImageView;
+using zxing::ArenaScope;
+using zxing::CountedArena;
+using zxing::Ref;
+using zxing::ResultPoint;
+
+namespace {
+const int kModulePx = 4;
+
+int decode(DecoderMgr &mgr, const std::vector<uint8_t> &pixels) {
+    const int side = fixture_side(kModulePx);
+    std::vector<std::string> texts;
+    std::vector<std::vector<Point2f>> points;
+    std::vector<std::vector<uint8_t>> raw_bytes;
+    int ret = mgr.decodeImage(ImageView(pixels.data(), side, side, side), false, texts, points, raw_bytes);
+    CHECK(ret != 0 || (texts.size() == 1 && texts[0] == kFixtureText));
+    return ret;
+}
+
+// An object kept past its scope holds the chunk, which starts over at the first scope closing after it is gone.
+void check_kept_object_holds_chunk() {
+    Ref<ResultPoint> kept;
+    {
+        ArenaScope arena;
+        kept = Ref<ResultPoint>(new ResultPoint(1.f, 2.f));
+    }
+    CHECK(CountedArena::carved() > 0);
+    kept = Ref<ResultPoint>();
+    { ArenaScope arena; }
+    CHECK(CountedArena::carved() == 0);
+}
+
+void check_decodes_leave_chunk_empty(DecoderMgr &mgr) {
+    const int side = fixture_side(kModulePx);
+    const std::vector<uint8_t> code = render_fixture(kModulePx, side);
+    const std::vector<uint8_t> blank(static_cast<size_t>(side) * side, 255);
+    for (int call = 0; call < 3; call++) {
+        CHECK(decode(mgr, code) == 0);
+        CHECK(CountedArena::carved() == 0);
+        CHECK(decode(mgr, blank) != 0);
+        CHECK(CountedArena::carved() == 0);
+    }
+}
+}  // namespace
+
+int main() {
+    check_kept_object_holds_chunk();
+
+    DecoderMgr serial;
+    check_decodes_leave_chunk_empty(serial);
+
+    // every binarizer as its own attempt, run in turn on this thread so the test sees its arena
+    DecoderMgr parallel;
+    parallel.setParallelFor([](int count, const std::function<void(int)> &body) {
+        for (int i = 0; i < count; i++) body(i);
+    });
+    check_decodes_leave_chunk_empty(parallel);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,57 @@
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/zxing/common/array.hpp"
+
+// A borrowed array reads the caller's elements in place through its const accessors. Anything that may write copies
+// them first, so the caller's elements are never changed and values and append see the whole array.
+
+using zxing::Array;
+using zxing::ArrayRef;
+
+namespace {
+
+const std::vector<char> kPixels = {1, 2, 3, 4, 5};
+
+// A fresh view of kPixels.
+ArrayRef<char> borrow_pixels() {
+    return ArrayRef<char>(Array<char>::borrow(kPixels.data(), static_cast<int>(kPixels.size())));
+}
+
+void check_reads_in_place() {
+    const ArrayRef<char> view = borrow_pixels();
+    CHECK(view->size() == 5);
+    CHECK(view.data() == kPixels.data());
+    CHECK(view[4] == 5);
+
+    // a copy of a view owns its elements
+    Array<char> copy(*view);
+    CHECK(copy.values() == kPixels);
+}
+
+void check_copies_on_write() {
+    ArrayRef<char> written = borrow_pixels();
+    written[0] = 9;
+    CHECK(written[0] == 9);
+    CHECK(written.data() != kPixels.data());
+    CHECK(kPixels[0] == 1);
+
+    ArrayRef<char> appended = borrow_pixels();
+    appended.append(6);
+    CHECK(appended->size() == 6);
+    CHECK(appended[0] == 1 && appended[5] == 6);
+
+    ArrayRef<char> listed = borrow_pixels();
+    CHECK(listed->values() == kPixels);
+    CHECK(listed->size() == 5);
+}
+
+}  // namespace
+
+int main() {
+    check_reads_in_place();
+    check_copies_on_write();
+    CHECK((kPixels == std::vector<char>{1, 2, 3, 4, 5}));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#include <string>
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/binarizer_stats.hpp"
+
+// Round trip of the binarizer statistics through their text form, and rejection of malformed text.
+
+using cv::wechat_qrcode::BinarizerMgr;
+using cv::wechat_qrcode::BinarizerStats;
+
+int main() {
+    const std::vector<BinarizerMgr::BINARIZER> base = {BinarizerMgr::Hybrid, BinarizerMgr::FastWindow,
+                                                       BinarizerMgr::SimpleAdaptive,
+                                                       BinarizerMgr::AdaptiveThreshold};
+    BinarizerStats stats;
+    stats.record(640, 480, BinarizerMgr::FastWindow, true, 12.5);
+    stats.record(640, 480, BinarizerMgr::FastWindow, false, 7.5);
+    stats.record(640, 480, BinarizerMgr::Hybrid, false, 20);
+    stats.record(4000, 3000, BinarizerMgr::AdaptiveThreshold, true, 3);
+    const std::string text = stats.save();
+
+    BinarizerStats loaded;
+    CHECK(loaded.load(text));
+    CHECK(loaded.save() == text);
+    CHECK(loaded.order(640, 480, base) == stats.order(640, 480, base));
+    CHECK(loaded.order(4000, 3000, base) == stats.order(4000, 3000, base));
+
+    // Every one of these is rejected and leaves the loaded counters as they were.
+    const std::vector<std::string> malformed = {
+        text.substr(0, text.size() - 3),  // last record cut short
+        text + "0 1 5",                   // truncated record at the end
+        text + "0 1 5 2",
+        text + "0 1 5 2 1.5 x\n",         // trailing garbage
+        "x\n",
+        "4 0 1 1 1\n",                    // size class out of range
+        "0 4 1 1 1\n",                    // binarizer out of range
+        "0 0 1 2 1\n",                    // more successes than attempts
+        "0 0 -1 0 1\n",
+        "0 0 1 1 -1\n",
+    };
+    for (const std::string &bad : malformed) {
+        CHECK(!loaded.load(bad));
+        CHECK(loaded.save() == text);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/zxing/common/bitmatrix.hpp"
+
+// A bit-packed matrix reads, copies, flips and splits into runs exactly like the same pixels stored
+// one per byte, including widths that end inside a word.
+
+using zxing::ArrayRef;
+using zxing::BitMatrix;
+using zxing::ErrorHandler;
+using zxing::Ref;
+
+namespace {
+
+unsigned int lcg_state = 12345;
+
+unsigned int next_random() {
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return lcg_state >> 16;
+}
+
+void check_same(BitMatrix& packed, BitMatrix& bytes) {
+    int width = bytes.getWidth();
+    int height = bytes.getHeight();
+    CHECK(packed.getWidth() == width && packed.getHeight() == height);
+    std::vector<unsigned char> row(width);
+    for (int y = 0; y < height; y++) {
+        packed.getRowBool(y, reinterpret_cast<bool*>(&row[0]));
+        for (int x = 0; x < width; x++) {
+            CHECK(packed.get(x, y) == bytes.get(x, y));
+            CHECK(row[x] == bytes.get(x, y));
+        }
+    }
+
+    packed.isInitRowCounters = false;
+    bytes.isInitRowCounters = false;
+    packed.initRowCounters();
+    bytes.initRowCounters();
+    for (int y = 0; y < height; y++) {
+        int count = bytes.getRowCounterOffsetEnd(y);
+        CHECK(packed.getRowCounterOffsetEnd(y) == count);
+        for (int i = 0; i < count; i++) {
+            CHECK(packed.getRowRecords(y)[i] == bytes.getRowRecords(y)[i]);
+            CHECK(packed.getRowRecordsOffset(y)[i] == bytes.getRowRecordsOffset(y)[i]);
+        }
+    }
+
+    ArrayRef<int> packedTopLeft = packed.getTopLeftOnBit();
+    ArrayRef<int> bytesTopLeft = bytes.getTopLeftOnBit();
+    CHECK(!packedTopLeft == !bytesTopLeft);
+    if (bytesTopLeft) {
+        CHECK(packedTopLeft[0] == bytesTopLeft[0] && packedTopLeft[1] == bytesTopLeft[1]);
+    }
+    ArrayRef<int> packedBottomRight = packed.getBottomRightOnBit();
+    ArrayRef<int> bytesBottomRight = bytes.getBottomRightOnBit();
+    CHECK(!packedBottomRight == !bytesBottomRight);
+    if (bytesBottomRight) {
+        CHECK(packedBottomRight[0] == bytesBottomRight[0] &&
+              packedBottomRight[1] == bytesBottomRight[1]);
+    }
+}
+
+}  // namespace
+
+int main() {
+    const int widths[] = {1, 7, 63, 64, 65, 130};
+    for (int width : widths) {
+        for (int height = 1; height <= 4; height++) {
+            // dense noise, long runs and an empty matrix
+            for (int density = 0; density < 3; density++) {
+                ErrorHandler err_handler;
+                Ref<BitMatrix> packed(
+                    new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
+                Ref<BitMatrix> bytes(new BitMatrix(width, height, err_handler));
+                CHECK(err_handler.ErrCode() == 0);
+
+                std::vector<unsigned char> row(width);
+                for (int y = 0; y < height; y++) {
+                    unsigned char color = 0;
+                    for (int x = 0; x < width; x++) {
+                        if (density == 0) {
+                            color = next_random() & 1;
+                        } else if (density == 1 && next_random() % 23 == 0) {
+                            color ^= 1;
+                        }
+                        row[x] = color;
+                    }
+                    packed->setRowBytes(y, &row[0]);
+                    bytes->setRowBytes(y, &row[0]);
+                }
+                check_same(*packed, *bytes);
+
+                packed->flipAll();
+                bytes->flipAll();
+                check_same(*packed, *bytes);
+
+                Ref<BitMatrix> packedInverted(
+                    new BitMatrix(width, height, BitMatrix::BIT_PACKED, err_handler));
+                Ref<BitMatrix> bytesInverted(new BitMatrix(width, height, err_handler));
+                packedInverted->invertedCopyOf(packed, err_handler);
+                bytesInverted->invertedCopyOf(bytes, err_handler);
+                CHECK(err_handler.ErrCode() == 0);
+                CHECK(packedInverted->getStorage() == BitMatrix::BIT_PACKED);
+                check_same(*packedInverted, *bytesInverted);
+
+                packedInverted->xxor(packed);
+                bytesInverted->xxor(bytes);
+                check_same(*packedInverted, *bytesInverted);
+
+                int x = (int)(next_random() % width);
+                int y = (int)(next_random() % height);
+                packed->flip(x, y);
+                bytes->flip(x, y);
+                packed->swap(0, 0, width - 1, height - 1);
+                bytes->swap(0, 0, width - 1, height - 1);
+                Ref<BitMatrix> packedCopy(new BitMatrix(1, 1, err_handler));
+                packedCopy->copyOf(packed, err_handler);
+                CHECK(packedCopy->getStorage() == BitMatrix::BIT_PACKED);
+                check_same(*packedCopy, *bytes);
+
+                packed->clear();
+                bytes->clear();
+                check_same(*packed, *bytes);
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "zzt_qrcode/qrcode.h"
+
+// A call whose budget is already spent, or whose token was cancelled before it started, stops at the first check
+// and still hands out a result list, empty here. Without a limit, or with a token nobody cancels, the call decodes
+// as usual. Invalid tokens are rejected.
+
+namespace {
+
+const int kModulePx = 4;
+
+const std::vector<uint8_t> kPixels = render_fixture(kModulePx, fixture_side(kModulePx));
+
+// The fixture as raw gray pixels.
+zzt_qrcode_image_t fixture_image() {
+    zzt_qrcode_image_t image = {};
+    image.type = ZZT_QRCODE_IMAGE_PIXELS;
+    image.data = kPixels.data();
+    image.format = ZZT_QRCODE_PIXEL_GRAY;
+    image.width = fixture_side(kModulePx);
+    image.height = image.width;
+    return image;
+}
+
+// Decodes the fixture with the call options, checking the error and the number of codes in the result.
+void check_call(zzt_qrcode_detector_h detector, const zzt_qrcode_call_options_t *call_options,
+                zzt_qrcode_error_t expected, int expected_count) {
+    const zzt_qrcode_image_t image = fixture_image();
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_image(detector, &image, call_options, &result) == expected);
+    CHECK(result != nullptr);
+    int count = -1;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    CHECK(count == expected_count);
+    if (count > 0) {
+        char text[64];
+        int text_size = sizeof(text);
+        CHECK(zzt_qrcode_get_result_text(result, 0, text, &text_size) == ZZT_QRCODE_OK);
+        CHECK(strcmp(text, kFixtureText) == 0);
+    }
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+}
+
+}  // namespace
+
+int main() {
+    zzt_qrcode_detector_h detector = create_plain_detector();
+    CHECK(detector != nullptr);
+
+    check_call(detector, nullptr, ZZT_QRCODE_OK, 1);
+
+    zzt_qrcode_call_options_t call_options = {};
+    call_options.timeout_ms = -1;
+    check_call(detector, &call_options, ZZT_QRCODE_OK, 1);
+    call_options.timeout_ms = 0;
+    check_call(detector, &call_options, ZZT_QRCODE_ERROR_TIMEOUT, 0);
+
+    call_options.timeout_ms = -1;
+    call_options.cancel_token = zzt_qrcode_create_cancel_token();
+    CHECK(call_options.cancel_token != nullptr);
+    check_call(detector, &call_options, ZZT_QRCODE_OK, 1);
+    CHECK(zzt_qrcode_cancel(call_options.cancel_token) == ZZT_QRCODE_OK);
+    check_call(detector, &call_options, ZZT_QRCODE_ERROR_CANCELLED, 0);
+    // a cancelled token stays cancelled
+    check_call(detector, &call_options, ZZT_QRCODE_ERROR_CANCELLED, 0);
+    CHECK(zzt_qrcode_release_cancel_token(call_options.cancel_token) == ZZT_QRCODE_OK);
+
+    // the released token no longer names one
+    const zzt_qrcode_image_t image = fixture_image();
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_image(detector, &image, &call_options, &result) ==
+          ZZT_QRCODE_ERROR_INVALID_HANDLE);
+    CHECK(result == nullptr);
+    CHECK(zzt_qrcode_cancel(call_options.cancel_token) == ZZT_QRCODE_ERROR_INVALID_HANDLE);
+
+    CHECK(zzt_qrcode_release_detector(detector) == ZZT_QRCODE_OK);
+    return EXIT_SUCCESS;
+}
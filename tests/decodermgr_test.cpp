@@ -0,0 +1,67 @@
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/decodermgr.hpp"
+
+// A DecoderMgr is pooled and reused by the detector, so every decodeImage call has to start the binarizer rotation
+// over instead of going on from wherever the previous call stopped.
+
+using cv::Point2f;
+using cv::wechat_qrcode::BinarizerMgr;
+using cv::wechat_qrcode::DecodeControl;
+using cv::wechat_qrcode::DecodeStats;
+using cv::wechat_qrcode::DecoderMgr;
+using cv::wechat_qrcode::ImageView;
+
+namespace {
+int decode(DecoderMgr &mgr, const ImageView &img, std::vector<std::string> &texts, DecodeStats *stats,
+           DecodeControl *control) {
+    std::vector<std::vector<Point2f>> points;
+    std::vector<std::vector<uint8_t>> raw_bytes;
+    texts.clear();
+    return mgr.decodeImage(img, false, texts, points, raw_bytes, stats, control);
+}
+}  // namespace
+
+int main() {
+    DecoderMgr mgr;
+    std::vector<std::string> texts;
+
+    const int module_px = 4;
+    const int side = fixture_side(module_px);
+    std::vector<uint8_t> code = render_fixture(module_px, side);
+    CHECK(decode(mgr, ImageView(code.data(), side, side, side), texts, nullptr, nullptr) == 0);
+    CHECK(texts.size() == 1 && texts[0] == kFixtureText);
+
+    // The adaptive threshold binarizer does not decode the fixture and the hybrid one does, so a rotation starting
+    // with them stops on its second entry. Every call must still start from the first one, which a call going on
+    // from where the previous one stopped would skip.
+    mgr.setBinarizers({BinarizerMgr::AdaptiveThreshold, BinarizerMgr::Hybrid, BinarizerMgr::FastWindow});
+    for (int call = 0; call < 3; call++) {
+        DecodeStats stats;
+        CHECK(decode(mgr, ImageView(code.data(), side, side, side), texts, &stats, nullptr) == 0);
+        CHECK(texts.size() == 1 && texts[0] == kFixtureText);
+        CHECK(stats.binarizer_attempts[BinarizerMgr::AdaptiveThreshold] == 1);
+        CHECK(stats.binarizer_attempts[BinarizerMgr::Hybrid] == 1);
+        CHECK(stats.binarizer_successes[BinarizerMgr::Hybrid] == 1);
+        CHECK(stats.binarizer_attempts[BinarizerMgr::FastWindow] == 0);
+    }
+
+    // A call cancelled before its first binarizer leaves the next one to start over as well.
+    std::atomic<bool> cancel{true};
+    DecodeControl cancelled(-1, &cancel);
+    DecodeStats stats;
+    CHECK(decode(mgr, ImageView(code.data(), side, side, side), texts, &stats, &cancelled) != 0);
+    CHECK(stats.binarizer_attempts[BinarizerMgr::AdaptiveThreshold] == 0);
+    CHECK(stats.binarizer_attempts[BinarizerMgr::Hybrid] == 0);
+    stats = DecodeStats();
+    CHECK(decode(mgr, ImageView(code.data(), side, side, side), texts, &stats, nullptr) == 0);
+    CHECK(stats.binarizer_attempts[BinarizerMgr::AdaptiveThreshold] == 1);
+    CHECK(stats.binarizer_attempts[BinarizerMgr::Hybrid] == 1);
+    return EXIT_SUCCESS;
+}
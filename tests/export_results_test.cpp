@@ -0,0 +1,110 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "zzt_qrcode/qrcode.h"
+
+// zzt_qrcode_export_results lays out a header, one entry per code and then the points, raw bytes and texts of
+// every code, holding the same values the per-code getters return. Without the detector model the image is one
+// candidate, so the result holds a single code.
+
+int main() {
+    zzt_qrcode_detector_h detector = create_plain_detector();
+    CHECK(detector != nullptr);
+
+    const int width = fixture_side(4), height = width;
+    std::vector<uint8_t> pixels = render_fixture(4, width);
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, pixels.data(), ZZT_QRCODE_PIXEL_GRAY, width, height, 0,
+                                              &result) == ZZT_QRCODE_OK);
+    int count = 0;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    CHECK(count == 1);
+
+    int size = 0;
+    CHECK(zzt_qrcode_export_results(result, nullptr, nullptr) == ZZT_QRCODE_ERROR_INVALID_ARGUMENT);
+    CHECK(zzt_qrcode_export_results(result, nullptr, &size) == ZZT_QRCODE_OK);
+    const int table_size =
+        static_cast<int>(sizeof(zzt_qrcode_export_header_t) + count * sizeof(zzt_qrcode_export_entry_t));
+    CHECK(size > table_size);
+
+    // int storage keeps the buffer 4-byte aligned
+    std::vector<int> storage((size + sizeof(int) - 1) / sizeof(int) + 1);
+    unsigned char *buffer = reinterpret_cast<unsigned char *>(storage.data());
+    int small_size = size - 1;
+    CHECK(zzt_qrcode_export_results(result, buffer, &small_size) == ZZT_QRCODE_ERROR_BUFFER_TOO_SMALL);
+    CHECK(small_size == size);
+
+    // one spare byte past the layout that must stay untouched
+    const int capacity = size + 1;
+    buffer[size] = 0xA5;
+    int buffer_size = capacity;
+    CHECK(zzt_qrcode_export_results(result, buffer, &buffer_size) == ZZT_QRCODE_OK);
+    CHECK(buffer_size == size);
+    CHECK(buffer[size] == 0xA5);
+
+    const auto *header = reinterpret_cast<const zzt_qrcode_export_header_t *>(buffer);
+    const auto *entries = reinterpret_cast<const zzt_qrcode_export_entry_t *>(buffer + sizeof(*header));
+    CHECK(header->size == size);
+    CHECK(header->count == count);
+
+    // points, raw bytes and texts each follow on from the previous code, in that order
+    int points_end = table_size;
+    for (int i = 0; i < count; i++) {
+        const zzt_qrcode_export_entry_t &entry = entries[i];
+        CHECK(entry.points_offset == points_end);
+        CHECK(entry.points_offset % static_cast<int>(sizeof(float)) == 0);
+        points_end += entry.points_count * static_cast<int>(sizeof(float));
+    }
+    int raw_bytes_end = points_end;
+    for (int i = 0; i < count; i++) {
+        CHECK(entries[i].raw_bytes_offset == raw_bytes_end);
+        CHECK(entries[i].raw_bytes_size > 0);
+        raw_bytes_end += entries[i].raw_bytes_size;
+    }
+    int text_end = raw_bytes_end;
+    for (int i = 0; i < count; i++) {
+        CHECK(entries[i].text_offset == text_end);
+        text_end += entries[i].text_size + 1;
+    }
+    CHECK(text_end == size);
+
+    for (int i = 0; i < count; i++) {
+        const zzt_qrcode_export_entry_t &entry = entries[i];
+
+        int text_size = 0;
+        CHECK(zzt_qrcode_get_result_text(result, i, nullptr, &text_size) == ZZT_QRCODE_OK);
+        std::vector<char> text(text_size);
+        CHECK(zzt_qrcode_get_result_text(result, i, text.data(), &text_size) == ZZT_QRCODE_OK);
+        CHECK(entry.text_size == text_size - 1);
+        const char *exported_text = reinterpret_cast<const char *>(buffer + entry.text_offset);
+        CHECK(exported_text[entry.text_size] == '\0');
+        CHECK(strcmp(exported_text, text.data()) == 0);
+        CHECK(strcmp(exported_text, kFixtureText) == 0);
+
+        int points_size = 0;
+        CHECK(zzt_qrcode_get_result_points(result, i, nullptr, &points_size) == ZZT_QRCODE_OK);
+        std::vector<float> points(points_size);
+        CHECK(zzt_qrcode_get_result_points(result, i, points.data(), &points_size) == ZZT_QRCODE_OK);
+        CHECK(entry.points_count == points_size);
+        const float *exported_points = reinterpret_cast<const float *>(buffer + entry.points_offset);
+        CHECK(memcmp(exported_points, points.data(), points_size * sizeof(float)) == 0);
+    }
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+    CHECK(zzt_qrcode_export_results(result, nullptr, &size) == ZZT_QRCODE_ERROR_INVALID_HANDLE);
+
+    // An empty result is just the header.
+    std::vector<uint8_t> blank(static_cast<size_t>(width) * height, 255);
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, blank.data(), ZZT_QRCODE_PIXEL_GRAY, width, height, 0,
+                                              &result) == ZZT_QRCODE_OK);
+    buffer_size = capacity;
+    CHECK(zzt_qrcode_export_results(result, buffer, &buffer_size) == ZZT_QRCODE_OK);
+    CHECK(buffer_size == static_cast<int>(sizeof(zzt_qrcode_export_header_t)));
+    CHECK(header->size == buffer_size && header->count == 0);
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+
+    CHECK(zzt_qrcode_release_detector(detector) == ZZT_QRCODE_OK);
+    return EXIT_SUCCESS;
+}
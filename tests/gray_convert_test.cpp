@@ -0,0 +1,77 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/gray_convert.hpp"
+
+// Every pixel layout converts to the same gray as the scalar (77 R + 150 G + 29 B) >> 8, whichever of the AVX2, SSE2
+// or NEON bodies and the scalar tail handle it. The widths cover rows shorter than any vector step, rows that end in
+// a tail after the AVX2 body, after the SSE2 body and after both, each with tight and padded strides. Bytes past the
+// width of a gray row are left alone.
+
+using cv::wechat_qrcode::GrayPixelLayout;
+using cv::wechat_qrcode::convertToGray;
+using cv::wechat_qrcode::grayPixelSize;
+
+namespace {
+
+const int kWidths[] = {1, 15, 16, 17, 18, 33, 34, 50, 67};
+const int kHeight = 3;
+const size_t kPadding[] = {0, 5};
+const uint8_t kUntouched = 0xa5;
+
+struct Layout {
+    GrayPixelLayout layout;
+    // byte offsets of R, G and B in a pixel
+    int r, g, b;
+};
+
+const Layout kLayouts[] = {
+    {cv::wechat_qrcode::GRAY_FROM_RGB, 0, 1, 2},  {cv::wechat_qrcode::GRAY_FROM_BGR, 2, 1, 0},
+    {cv::wechat_qrcode::GRAY_FROM_RGBA, 0, 1, 2}, {cv::wechat_qrcode::GRAY_FROM_BGRA, 2, 1, 0},
+    {cv::wechat_qrcode::GRAY_FROM_ARGB, 1, 2, 3}, {cv::wechat_qrcode::GRAY_FROM_ABGR, 3, 2, 1},
+};
+
+// Deterministic pixels, the first row saturated so the widest sums are covered.
+std::vector<uint8_t> make_pixels(size_t size, size_t row_bytes) {
+    std::vector<uint8_t> pixels(size);
+    uint32_t state = 12345;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1103515245u + 12345u;
+        pixels[i] = i < row_bytes ? 255 : static_cast<uint8_t>(state >> 16);
+    }
+    return pixels;
+}
+
+void check_layout(const Layout &l, int width, size_t src_padding, size_t dst_padding) {
+    const int pixel_size = grayPixelSize(l.layout);
+    const size_t src_stride = static_cast<size_t>(width) * pixel_size + src_padding;
+    const size_t dst_stride = static_cast<size_t>(width) + dst_padding;
+    const std::vector<uint8_t> src = make_pixels(src_stride * kHeight, src_stride);
+    std::vector<uint8_t> dst(dst_stride * kHeight, kUntouched);
+
+    convertToGray(src.data(), l.layout, width, kHeight, src_stride, dst.data(), dst_stride);
+
+    for (int y = 0; y < kHeight; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t *p = &src[y * src_stride + static_cast<size_t>(x) * pixel_size];
+            const int expected = (77 * p[l.r] + 150 * p[l.g] + 29 * p[l.b]) >> 8;
+            CHECK(dst[y * dst_stride + x] == expected);
+        }
+        for (size_t x = width; x < dst_stride; x++) CHECK(dst[y * dst_stride + x] == kUntouched);
+    }
+}
+
+}  // namespace
+
+int main() {
+    for (const Layout &l : kLayouts) {
+        for (int width : kWidths) {
+            for (size_t src_padding : kPadding) {
+                for (size_t dst_padding : kPadding) check_layout(l, width, src_padding, dst_padding);
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
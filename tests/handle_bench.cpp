@@ -0,0 +1,171 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "handle.h"
+
+// Stress benchmark for the handle registry. Threads keep looking up small objects, which is what result getters such
+// as zzt_qrcode_get_result_text do, either each on handles of its own or all on the same handles. Registry lookups
+// through borrow and get are compared against a single global shared_mutex, the design they replaced.
+
+namespace {
+struct Payload {
+    int value = 0;
+};
+
+struct RegistryPayload : Payload, zzt::qrcode::Handle<RegistryPayload, intptr_t> {};
+
+// The registry looked up through get, which also copies the owning shared_ptr.
+struct SharedLookup {
+    static intptr_t create_handle() { return RegistryPayload::create_handle(); }
+    static bool release_handle(intptr_t handle) { return RegistryPayload::release_handle(handle); }
+    static std::shared_ptr<RegistryPayload> get(intptr_t handle) { return RegistryPayload::get(handle); }
+};
+
+// The registry looked up through borrow, as the result getters do.
+struct BorrowedLookup {
+    static intptr_t create_handle() { return RegistryPayload::create_handle(); }
+    static bool release_handle(intptr_t handle) { return RegistryPayload::release_handle(handle); }
+    static RegistryPayload::Borrowed get(intptr_t handle) { return RegistryPayload::borrow(handle); }
+};
+
+class GlobalLockRegistry {
+public:
+    static intptr_t create_handle() {
+        static std::atomic<intptr_t> next_handle{1};
+        intptr_t handle = next_handle++;
+        std::unique_lock g(mutex());
+        map().emplace(handle, std::make_shared<Payload>());
+        return handle;
+    }
+
+    static bool release_handle(intptr_t handle) {
+        std::unique_lock g(mutex());
+        return map().erase(handle) > 0;
+    }
+
+    static std::shared_ptr<Payload> get(intptr_t handle) {
+        std::shared_lock g(mutex());
+        auto iter = map().find(handle);
+        return iter == map().end() ? nullptr : iter->second;
+    }
+
+private:
+    static std::unordered_map<intptr_t, std::shared_ptr<Payload>>& map() {
+        static std::unordered_map<intptr_t, std::shared_ptr<Payload>> map;
+        return map;
+    }
+
+    static std::shared_mutex& mutex() {
+        static std::shared_mutex mutex;
+        return mutex;
+    }
+};
+
+// Returns lookups per second summed over all threads. With shared set every thread looks up the same handles.
+template <typename Registry>
+double run(int thread_count, int handles_per_thread, bool shared, std::chrono::milliseconds duration) {
+    std::vector<intptr_t> shared_handles;
+    if (shared) {
+        for (int i = 0; i < handles_per_thread; ++i) {
+            shared_handles.push_back(Registry::create_handle());
+        }
+    }
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::atomic<int> sink{0};  // keeps the lookups from being optimized away
+    std::vector<uint64_t> counts(thread_count, 0);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<intptr_t> handles = shared_handles;
+            if (!shared) {
+                for (int i = 0; i < handles_per_thread; ++i) {
+                    handles.push_back(Registry::create_handle());
+                }
+            }
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            uint64_t count = 0;
+            int local_sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (intptr_t handle : handles) {
+                    auto ptr = Registry::get(handle);
+                    local_sink += ptr ? ptr->value : 1;
+                }
+                count += handles.size();
+            }
+            counts[t] = count;
+            sink += local_sink;
+
+            if (!shared) {
+                for (intptr_t handle : handles) {
+                    Registry::release_handle(handle);
+                }
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true, std::memory_order_relaxed);
+    auto end = std::chrono::steady_clock::now();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (intptr_t handle : shared_handles) {
+        Registry::release_handle(handle);
+    }
+
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    return total / std::chrono::duration<double>(end - begin).count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    int max_threads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int handles_per_thread = argc > 2 ? std::atoi(argv[2]) : 16;
+    int duration_ms = argc > 3 ? std::atoi(argv[3]) : 500;
+    if (max_threads <= 0 || handles_per_thread <= 0 || duration_ms <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [max_threads] [handles_per_thread] [duration_ms]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (bool shared : {false, true}) {
+        std::cout << (shared ? "all threads on the same handles" : "every thread on its own handles") << std::endl;
+        std::cout << std::setw(8) << "threads" << std::setw(16) << "global Mops/s" << std::setw(16) << "get Mops/s"
+                  << std::setw(16) << "borrow Mops/s" << std::setw(10) << "speedup" << std::endl;
+        for (int threads = 1;; threads *= 2) {
+            if (threads > max_threads) {
+                threads = max_threads;
+            }
+            auto duration = std::chrono::milliseconds(duration_ms);
+            double global = run<GlobalLockRegistry>(threads, handles_per_thread, shared, duration);
+            double get = run<SharedLookup>(threads, handles_per_thread, shared, duration);
+            double borrow = run<BorrowedLookup>(threads, handles_per_thread, shared, duration);
+            std::cout << std::setw(8) << threads << std::setw(16) << global / 1e6 << std::setw(16) << get / 1e6
+                      << std::setw(16) << borrow / 1e6 << std::setw(10) << borrow / global << std::endl;
+            if (threads == max_threads) {
+                break;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "handle.h"
+#include "test_check.h"
+
+// Handles name their object until released and never again, a borrowed object outlives a concurrent release until
+// the borrow ends, and lookups racing with releases and reuse of the slots only ever see live objects.
+
+namespace {
+std::atomic<int> live_objects{0};
+
+struct Payload : zzt::qrcode::Handle<Payload, intptr_t> {
+    explicit Payload(int value) : value(value) { live_objects++; }
+    ~Payload() {
+        value = -1;
+        live_objects--;
+    }
+    int value;
+};
+
+void check_single_thread() {
+    intptr_t first = Payload::create_handle(1);
+    intptr_t second = Payload::create_handle(2);
+    CHECK(first != 0 && second != 0 && first != second);
+    CHECK(Payload::get(first)->value == 1);
+    CHECK(Payload::borrow(second)->value == 2);
+
+    // never handed out, or a released one whose slot has been reused
+    CHECK(Payload::get(0) == nullptr);
+    CHECK(!Payload::borrow(first ^ 1));
+    CHECK(Payload::release_handle(first));
+    CHECK(!Payload::release_handle(first));
+    CHECK(!Payload::borrow(first));
+    intptr_t reused = Payload::create_handle(3);
+    CHECK(reused != first);
+    CHECK(!Payload::borrow(first));
+    CHECK(Payload::borrow(reused)->value == 3);
+
+    // a borrow keeps the object until it ends, also when the release comes first
+    {
+        auto borrowed = Payload::borrow(second);
+        CHECK(Payload::release_handle(second));
+        CHECK(!Payload::borrow(second));
+        CHECK(borrowed->value == 2);
+    }
+    // the slot is reclaimed by the next release
+    CHECK(Payload::release_handle(reused));
+    CHECK(live_objects == 0);
+
+    // more nested borrows than hazard pointers fall back to sharing the object
+    std::vector<intptr_t> handles;
+    std::vector<Payload::Borrowed> borrows;
+    for (int i = 0; i < Payload::hazards_per_thread + 2; i++) {
+        handles.push_back(Payload::create_handle(10 + i));
+        borrows.push_back(Payload::borrow(handles.back()));
+    }
+    for (int i = 0; i < static_cast<int>(handles.size()); i++) {
+        CHECK(Payload::release_handle(handles[i]));
+        CHECK(borrows[i]->value == 10 + i);
+    }
+    borrows.clear();
+    CHECK(Payload::release_handle(Payload::create_handle(0)));
+    CHECK(live_objects == 0);
+}
+
+// Readers keep looking up a rotating set of handles while a writer releases them and creates new ones in the
+// slots they free. A lookup either fails or sees the value the handle was created with.
+void check_concurrent() {
+    const int handle_count = 8;
+    const int rounds = 20000;
+    std::vector<std::atomic<intptr_t>> handles(handle_count);
+    for (int i = 0; i < handle_count; i++) handles[i] = Payload::create_handle(i);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < handle_count; i++) {
+                    if (auto borrowed = Payload::borrow(handles[i].load())) {
+                        CHECK(borrowed->value % handle_count == i);
+                    }
+                    if (auto shared = Payload::get(handles[i].load())) {
+                        CHECK(shared->value % handle_count == i);
+                    }
+                }
+            }
+        });
+    }
+    for (int round = 1; round <= rounds; round++) {
+        int i = round % handle_count;
+        intptr_t old = handles[i].exchange(Payload::create_handle(round * handle_count + i));
+        CHECK(Payload::release_handle(old));
+    }
+    stop = true;
+    for (auto& reader : readers) reader.join();
+    for (auto& handle : handles) CHECK(Payload::release_handle(handle.load()));
+    CHECK(Payload::release_handle(Payload::create_handle(0)));
+    CHECK(live_objects == 0);
+}
+}  // namespace
+
+int main() {
+    check_single_thread();
+    check_concurrent();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/wechat_qrcode.hpp"
+#include "qr_fixture.h"
+#include "test_check.h"
+
+// max_results caps the codes of a call that has more candidates holding one, serial or through parallel_for. The
+// candidates here are the tracked regions of a stream over two codes side by side, which the whole image pass
+// alone cannot tell apart.
+
+using cv::wechat_qrcode::StreamState;
+using cv::wechat_qrcode::WeChatQRCode;
+
+namespace {
+
+const int kModulePx = 4;
+const int kGap = 40;
+
+// Two fixtures next to each other, kGap pixels apart.
+std::vector<uint8_t> render_pair() {
+    const int side = fixture_side(kModulePx);
+    const int width = 2 * side + kGap;
+    const std::vector<uint8_t> code = render_fixture(kModulePx, side);
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * side, 255);
+    for (int y = 0; y < side; y++) {
+        memcpy(&pixels[static_cast<size_t>(y) * width], &code[static_cast<size_t>(y) * side], side);
+        memcpy(&pixels[static_cast<size_t>(y) * width + side + kGap], &code[static_cast<size_t>(y) * side], side);
+    }
+    return pixels;
+}
+
+// Vertices of the code whose tile starts at x, inside its quiet zone.
+cv::Mat code_points(int x) {
+    const float quiet = 4.f * kModulePx;
+    const float size = fixture_side(kModulePx) - 2 * quiet;
+    cv::Mat points(4, 2, CV_32FC1);
+    const float corners[4][2] = {{0, 0}, {size, 0}, {size, size}, {0, size}};
+    for (int i = 0; i < 4; i++) {
+        points.ptr<float>(i)[0] = x + quiet + corners[i][0];
+        points.ptr<float>(i)[1] = quiet + corners[i][1];
+    }
+    return points;
+}
+
+// Decodes the pair with both codes tracked, returning the number of codes.
+int decode_pair(WeChatQRCode &detector) {
+    const int side = fixture_side(kModulePx);
+    const int width = 2 * side + kGap;
+    const std::vector<uint8_t> pixels = render_pair();
+    StreamState state;
+    state.refresh_interval = 0;
+    state.tracked_points = {code_points(0), code_points(side + kGap)};
+    std::vector<cv::Mat> points;
+    std::vector<std::vector<uint8_t>> raw_bytes;
+    std::vector<std::string> texts =
+        detector.detectAndDecodeStream(pixels.data(), width, side, width, state, points, raw_bytes);
+    CHECK(points.size() == texts.size() && raw_bytes.size() == texts.size());
+    for (const auto &text : texts) CHECK(text == kFixtureText);
+    return static_cast<int>(texts.size());
+}
+
+WeChatQRCode::Options plain_options() {
+    WeChatQRCode::Options options;
+    options.use_nn_detector = false;
+    options.use_nn_sr = false;
+    options.scales = {1.f};
+    return options;
+}
+
+void check_caps(const WeChatQRCode::Options &options) {
+    WeChatQRCode::Options unlimited = options;
+    WeChatQRCode both(unlimited);
+    CHECK(decode_pair(both) == 2);
+
+    WeChatQRCode::Options capped = options;
+    capped.max_results = 1;
+    WeChatQRCode one(capped);
+    CHECK(decode_pair(one) == 1);
+}
+
+}  // namespace
+
+int main() {
+    // without the tracked regions neither code is found
+    {
+        const int side = fixture_side(kModulePx);
+        const int width = 2 * side + kGap;
+        const std::vector<uint8_t> pixels = render_pair();
+        WeChatQRCode detector(plain_options());
+        std::vector<cv::Mat> points;
+        std::vector<std::vector<uint8_t>> raw_bytes;
+        CHECK(detector.detectAndDecode(pixels.data(), width, side, width, points, raw_bytes).empty());
+    }
+
+    check_caps(plain_options());
+
+    // every candidate as its own task, run in turn on this thread
+    WeChatQRCode::Options parallel = plain_options();
+    parallel.parallel_for = [](int count, const std::function<void(int)> &body) {
+        for (int i = 0; i < count; i++) body(i);
+    };
+    check_caps(parallel);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "zzt_qrcode/qrcode.h"
+
+// Detectors that decode on the shared worker pool, also trying all scales of a candidate or all binarizers of an
+// attempt at once, find the same code as the serial one, and nothing in an image without a code, call after call.
+
+namespace {
+
+const int kModulePx = 4;
+
+// Options of create_plain_detector, decoding on the caller and every pool thread.
+zzt_qrcode_options_t parallel_options() {
+    zzt_qrcode_options_t options;
+    zzt_qrcode_init_options(&options);
+    options.use_nn_detector = 0;
+    options.use_super_resolution = 0;
+    options.scales[0] = 1.f;
+    options.scale_count = 1;
+    options.decode_threads = 0;
+    return options;
+}
+
+// Decodes the pixels and returns the number of codes, checking that any code found is the fixture.
+int decode(zzt_qrcode_detector_h detector, const std::vector<uint8_t> &pixels) {
+    const int side = fixture_side(kModulePx);
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, pixels.data(), ZZT_QRCODE_PIXEL_GRAY, side, side, side,
+                                              &result) == ZZT_QRCODE_OK);
+    int count = 0;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    for (int i = 0; i < count; i++) {
+        char text[64];
+        int text_size = sizeof(text);
+        CHECK(zzt_qrcode_get_result_text(result, i, text, &text_size) == ZZT_QRCODE_OK);
+        CHECK(strcmp(text, kFixtureText) == 0);
+    }
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+    return count;
+}
+
+void check_decodes(const zzt_qrcode_options_t &options) {
+    zzt_qrcode_detector_h detector = zzt_qrcode_create_detector_ex(&options);
+    CHECK(detector != nullptr);
+    const int side = fixture_side(kModulePx);
+    const std::vector<uint8_t> code = render_fixture(kModulePx, side);
+    const std::vector<uint8_t> blank(static_cast<size_t>(side) * side, 255);
+    for (int call = 0; call < 3; call++) {
+        CHECK(decode(detector, code) == 1);
+        CHECK(decode(detector, blank) == 0);
+    }
+    CHECK(zzt_qrcode_release_detector(detector) == ZZT_QRCODE_OK);
+}
+
+}  // namespace
+
+int main() {
+    // more than one helper even on a single core
+    CHECK(zzt_qrcode_set_worker_threads(3) == ZZT_QRCODE_OK);
+
+    zzt_qrcode_options_t options = parallel_options();
+    check_decodes(options);
+    options.decode_threads = 2;
+    check_decodes(options);
+
+    // every scale of the candidate at once, the first success cancelling the others
+    options = parallel_options();
+    options.speculative_scales = 1;
+    options.scales[0] = 0.5f;
+    options.scales[1] = 0.75f;
+    options.scales[2] = 1.f;
+    options.scale_count = 3;
+    check_decodes(options);
+
+    // every binarizer of an attempt at once, also when the first one in order fails on the fixture
+    options = parallel_options();
+    options.parallel_binarizers = 1;
+    check_decodes(options);
+    options.binarizers[0] = ZZT_QRCODE_BINARIZER_ADAPTIVE_THRESHOLD;
+    options.binarizers[1] = ZZT_QRCODE_BINARIZER_HYBRID;
+    options.binarizer_count = 2;
+    check_decodes(options);
+
+    // and both together
+    options.speculative_scales = 1;
+    options.scales[0] = 0.5f;
+    options.scales[1] = 1.f;
+    options.scale_count = 2;
+    check_decodes(options);
+    return EXIT_SUCCESS;
+}
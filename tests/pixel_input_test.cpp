@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "zzt_qrcode/qrcode.h"
+
+// Raw gray pixels, and the luma plane of YUV 4:2:0 pixels, decode the same whether their rows are contiguous, and
+// read in place, or padded to a larger stride. Only the first width bytes of every luma row are read, and the
+// caller's buffer is never written to.
+
+namespace {
+
+const int kModulePx = 4;
+
+unsigned int lcg_state = 4242;
+
+unsigned int next_random() {
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return lcg_state >> 16;
+}
+
+// The fixture with dark bytes in the padding of every row, which would break the code if they were read.
+std::vector<uint8_t> render_padded(int stride) {
+    const int side = fixture_side(kModulePx);
+    std::vector<uint8_t> pixels = render_fixture(kModulePx, stride);
+    for (int y = 0; y < side; y++) {
+        memset(&pixels[static_cast<size_t>(y) * stride + side], 0, stride - side);
+    }
+    return pixels;
+}
+
+// The luma rows followed by chroma planes of noise, which would break the code if they were read as gray.
+std::vector<uint8_t> append_chroma(std::vector<uint8_t> luma, int stride) {
+    const int side = fixture_side(kModulePx);
+    const size_t chroma_size = static_cast<size_t>(stride) * ((side + 1) / 2);
+    for (size_t i = 0; i < chroma_size; i++) {
+        luma.push_back(static_cast<uint8_t>(next_random()));
+    }
+    return luma;
+}
+
+// Decodes the pixels and checks they hold the fixture and were left as they were.
+void check_decodes(zzt_qrcode_detector_h detector, const std::vector<uint8_t> &pixels,
+                   zzt_qrcode_pixel_format_t format, int stride) {
+    const int side = fixture_side(kModulePx);
+    const std::vector<uint8_t> original = pixels;
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, pixels.data(), format, side, side, stride, &result) ==
+          ZZT_QRCODE_OK);
+    int count = 0;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    CHECK(count == 1);
+    char text[64];
+    int text_size = sizeof(text);
+    CHECK(zzt_qrcode_get_result_text(result, 0, text, &text_size) == ZZT_QRCODE_OK);
+    CHECK(strcmp(text, kFixtureText) == 0);
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+    CHECK(pixels == original);
+}
+
+}  // namespace
+
+int main() {
+    zzt_qrcode_detector_h detector = create_plain_detector();
+    CHECK(detector != nullptr);
+    const int side = fixture_side(kModulePx);
+
+    // contiguous rows, with the stride given or left at 0
+    std::vector<uint8_t> contiguous = render_fixture(kModulePx, side);
+    check_decodes(detector, contiguous, ZZT_QRCODE_PIXEL_GRAY, 0);
+    check_decodes(detector, contiguous, ZZT_QRCODE_PIXEL_GRAY, side);
+
+    // padded rows, through both the pixel and the image descriptor entry points
+    const int stride = side + 13;
+    std::vector<uint8_t> padded = render_padded(stride);
+    check_decodes(detector, padded, ZZT_QRCODE_PIXEL_GRAY, stride);
+
+    zzt_qrcode_image_t image = {};
+    image.type = ZZT_QRCODE_IMAGE_PIXELS;
+    image.data = padded.data();
+    image.format = ZZT_QRCODE_PIXEL_GRAY;
+    image.width = side;
+    image.height = side;
+    image.stride = stride;
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_image(detector, &image, nullptr, &result) == ZZT_QRCODE_OK);
+    int count = 0;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    CHECK(count == 1);
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+
+    // the luma plane of every YUV layout, contiguous and padded
+    const zzt_qrcode_pixel_format_t yuv_formats[] = {ZZT_QRCODE_PIXEL_NV21, ZZT_QRCODE_PIXEL_NV12,
+                                                     ZZT_QRCODE_PIXEL_I420, ZZT_QRCODE_PIXEL_YV12};
+    const std::vector<uint8_t> contiguous_yuv = append_chroma(contiguous, side);
+    const std::vector<uint8_t> padded_yuv = append_chroma(padded, stride);
+    for (zzt_qrcode_pixel_format_t format : yuv_formats) {
+        check_decodes(detector, contiguous_yuv, format, 0);
+        check_decodes(detector, padded_yuv, format, stride);
+        result = nullptr;
+        CHECK(zzt_qrcode_detect_and_decode_pixels(detector, padded_yuv.data(), format, side, side, side - 1,
+                                                  &result) == ZZT_QRCODE_ERROR_INVALID_ARGUMENT);
+        CHECK(result == nullptr);
+    }
+
+    // rows shorter than the image, and missing pixels
+    result = nullptr;
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, contiguous.data(), ZZT_QRCODE_PIXEL_GRAY, side, side,
+                                              side - 1, &result) == ZZT_QRCODE_ERROR_INVALID_ARGUMENT);
+    CHECK(result == nullptr);
+    CHECK(zzt_qrcode_detect_and_decode_pixels(detector, nullptr, ZZT_QRCODE_PIXEL_GRAY, side, side, 0, &result) ==
+          ZZT_QRCODE_ERROR_INVALID_ARGUMENT);
+
+    CHECK(zzt_qrcode_release_detector(detector) == ZZT_QRCODE_OK);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#ifndef ZZT_TEST_QR_FIXTURE_H
+#define ZZT_TEST_QR_FIXTURE_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "zzt_qrcode/qrcode.h"
+
+// A version 1-M QR code holding kFixtureText, rendered into gray pixels for the tests that need a code to decode.
+
+static const char *const kFixtureText = "zzt-qrcode";
+
+static const char *const kFixtureModules[] = {
+    "#######..####.#######",
+    "#.....#.#.#...#.....#",
+    "#.###.#...#.#.#.###.#",
+    "#.###.#..####.#.###.#",
+    "#.###.#.#.###.#.###.#",
+    "#.....#...##..#.....#",
+    "#######.#.#.#.#######",
+    ".....................",
+    "#.#.#.#.....#...#..#.",
+    ".####..###.#..#####.#",
+    "..##.##.##.#.#.##..##",
+    "...#....##.##...#..##",
+    ".#######.#.#....##...",
+    "........###....##...#",
+    "#######..##.#.###.###",
+    "#.....#...#....###.##",
+    "#.###.#.#.#.#...#....",
+    "#.###.#....#....#.##.",
+    "#.###.#.#..#.######.#",
+    "#.....#..#.###.....#.",
+    "#######.####..#.##.##",
+};
+
+// Side of the rendered image in pixels: the code plus a quiet zone of four modules on every side.
+static int fixture_side(int module_px) {
+    const int modules = static_cast<int>(strlen(kFixtureModules[0]));
+    return (modules + 8) * module_px;
+}
+
+// Gray pixels of the code, dark modules 0 and light 255, with rows stride bytes apart.
+static std::vector<uint8_t> render_fixture(int module_px, int stride) {
+    const int side = fixture_side(module_px);
+    std::vector<uint8_t> pixels(static_cast<size_t>(stride) * side, 255);
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            int my = y / module_px - 4;
+            int mx = x / module_px - 4;
+            const int modules = static_cast<int>(strlen(kFixtureModules[0]));
+            if (my >= 0 && mx >= 0 && my < modules && mx < modules && kFixtureModules[my][mx] == '#') {
+                pixels[static_cast<size_t>(y) * stride + x] = 0;
+            }
+        }
+    }
+    return pixels;
+}
+
+// A detector of the C API that decodes the whole image as one candidate at its own scale, so no model is needed.
+// Inline rather than static, so that the engine tests, which never call it, need not link the library.
+inline zzt_qrcode_detector_h create_plain_detector() {
+    zzt_qrcode_options_t options;
+    zzt_qrcode_init_options(&options);
+    options.use_nn_detector = 0;
+    options.use_super_resolution = 0;
+    options.scales[0] = 1.f;
+    options.scale_count = 1;
+    return zzt_qrcode_create_detector_ex(&options);
+}
+
+#endif  // ZZT_TEST_QR_FIXTURE_H
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/scale/scale_ladder.hpp"
+
+// The scale ladder reorders configured scales without adding to them, and keeps apart the statistics of
+// different custom scales.
+
+using cv::wechat_qrcode::ScaleLadder;
+
+int main() {
+    ScaleLadder ladder;
+    // Half a pixel per module calls for scale 4, the nearest standard scale is 2.
+    const float small_modules = 0.6f;
+
+    std::vector<float> configured = {1.f};
+    CHECK(ladder.order(small_modules, configured, false) == configured);
+    std::vector<float> extended = ladder.order(small_modules, {1.f}, true);
+    CHECK(extended.size() == 2 && extended[0] == 2.f && extended[1] == 1.f);
+
+    std::vector<float> custom = {1.5f, 3.f};
+    CHECK(ladder.order(small_modules, custom, false) == (std::vector<float>{3.f, 1.5f}));
+    // Successes of 1.5 must not carry over to 3, so enough of them put 1.5 first.
+    for (int i = 0; i < 20; i++) {
+        ladder.record(small_modules, 1.5f, true);
+        ladder.record(small_modules, 3.f, false);
+    }
+    CHECK(ladder.order(small_modules, custom, false) == (std::vector<float>{1.5f, 3.f}));
+    ScaleLadder fresh;
+    for (int i = 0; i < 20; i++) fresh.record(small_modules, 1.5f, true);
+    CHECK(fresh.order(small_modules, custom, false) == (std::vector<float>{1.5f, 3.f}));
+    for (int i = 0; i < 20; i++) fresh.record(small_modules, 3.f, true);
+    CHECK(fresh.order(small_modules, custom, false) == (std::vector<float>{3.f, 1.5f}));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "qr_fixture.h"
+#include "test_check.h"
+#include "zzt_qrcode/qrcode.h"
+
+// A stream runs the full pipeline on its first frame and serves the next ones from the region of the codes it
+// tracks, counting them as tracked calls. A reset, a frame without the code and the refresh interval each send the
+// next frame through the full pipeline again.
+
+namespace {
+
+const int kModulePx = 4;
+
+// Decodes the next frame and returns its tracked_calls, checking whether it held the fixture.
+int decode_frame(zzt_qrcode_stream_h stream, const std::vector<uint8_t> &pixels, bool has_code) {
+    const int side = fixture_side(kModulePx);
+    zzt_qrcode_result_h result = nullptr;
+    CHECK(zzt_qrcode_stream_decode_pixels(stream, pixels.data(), ZZT_QRCODE_PIXEL_GRAY, side, side, side,
+                                          &result) == ZZT_QRCODE_OK);
+    int count = 0;
+    CHECK(zzt_qrcode_get_result_size(result, &count) == ZZT_QRCODE_OK);
+    CHECK(count == (has_code ? 1 : 0));
+    if (has_code) {
+        char text[64];
+        int text_size = sizeof(text);
+        CHECK(zzt_qrcode_get_result_text(result, 0, text, &text_size) == ZZT_QRCODE_OK);
+        CHECK(strcmp(text, kFixtureText) == 0);
+    }
+    zzt_qrcode_stats_t stats;
+    CHECK(zzt_qrcode_get_result_stats(result, &stats) == ZZT_QRCODE_OK);
+    CHECK(stats.calls == 1);
+    CHECK(zzt_qrcode_release_result(result) == ZZT_QRCODE_OK);
+    return stats.tracked_calls;
+}
+
+}  // namespace
+
+int main() {
+    zzt_qrcode_detector_h detector = create_plain_detector();
+    CHECK(detector != nullptr);
+    CHECK(zzt_qrcode_set_stats_enabled(detector, 1) == ZZT_QRCODE_OK);
+    const int side = fixture_side(kModulePx);
+    const std::vector<uint8_t> code = render_fixture(kModulePx, side);
+    const std::vector<uint8_t> blank(static_cast<size_t>(side) * side, 255);
+
+    CHECK(zzt_qrcode_create_stream(detector, -1) == nullptr);
+    zzt_qrcode_stream_h stream = zzt_qrcode_create_stream(detector, 0);
+    CHECK(stream != nullptr);
+
+    // nothing tracked yet, then the code of the previous frame
+    CHECK(decode_frame(stream, code, true) == 0);
+    CHECK(decode_frame(stream, code, true) == 1);
+    CHECK(decode_frame(stream, code, true) == 1);
+
+    // a reset forgets the code, and so does a frame that lost it
+    CHECK(zzt_qrcode_reset_stream(stream) == ZZT_QRCODE_OK);
+    CHECK(decode_frame(stream, code, true) == 0);
+    CHECK(decode_frame(stream, blank, false) == 0);
+    CHECK(decode_frame(stream, code, true) == 0);
+    CHECK(decode_frame(stream, code, true) == 1);
+
+    zzt_qrcode_stats_t stats;
+    CHECK(zzt_qrcode_get_detector_stats(detector, &stats) == ZZT_QRCODE_OK);
+    CHECK(stats.calls == 7);
+    CHECK(stats.tracked_calls == 3);
+    CHECK(zzt_qrcode_release_stream(stream) == ZZT_QRCODE_OK);
+
+    // every second frame runs the full pipeline
+    stream = zzt_qrcode_create_stream(detector, 2);
+    CHECK(stream != nullptr);
+    CHECK(decode_frame(stream, code, true) == 0);
+    CHECK(decode_frame(stream, code, true) == 1);
+    CHECK(decode_frame(stream, code, true) == 0);
+    CHECK(decode_frame(stream, code, true) == 1);
+    CHECK(zzt_qrcode_release_stream(stream) == ZZT_QRCODE_OK);
+
+    CHECK(zzt_qrcode_release_detector(detector) == ZZT_QRCODE_OK);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+#ifndef ZZT_TEST_CHECK_H
+#define ZZT_TEST_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// Fails the test program at the first expectation that does not hold.
+#define CHECK(cond)                                                                          \
+    do {                                                                                     \
+        if (!(cond)) {                                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            std::exit(EXIT_FAILURE);                                                         \
+        }                                                                                    \
+    } while (0)
+
+#endif  // ZZT_TEST_CHECK_H
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <vector>
+
+#include "test_check.h"
+#include "wechat_qrcode/src/precomp.hpp"
+#include "wechat_qrcode/src/zxing/common/unicomblock.hpp"
+
+// Component sizes and bounding boxes from the run labeling of UnicomBlock match a flood fill over
+// the pixels, on random matrices, on matrices whose components touch the borders, and after the
+// labels are reused for the inverted matrix.
+
+using zxing::BitMatrix;
+using zxing::ErrorHandler;
+using zxing::Ref;
+using zxing::UnicomBlock;
+
+namespace {
+
+unsigned int lcg_state = 2024;
+
+unsigned int next_random() {
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return lcg_state >> 16;
+}
+
+// 4-connected components of equal pixels by breadth-first search, with the size counting one more
+// than the pixels up to 0xFFFF, and the bounding box corners packed as y << 16 | x.
+struct Reference {
+    std::vector<int> label;
+    std::vector<int> size;
+    std::vector<int> minPoint;
+    std::vector<int> maxPoint;
+
+    explicit Reference(BitMatrix& matrix) {
+        const int width = matrix.getWidth();
+        const int height = matrix.getHeight();
+        label.assign(width * height, -1);
+        std::vector<int> queue;
+        for (int start = 0; start < width * height; start++) {
+            if (label[start] >= 0) continue;
+            const int component = int(size.size());
+            const unsigned char value = matrix.get(start % width, start / width);
+            int pixels = 0, minX = width, minY = height, maxX = 0, maxY = 0;
+            queue.assign(1, start);
+            label[start] = component;
+            while (!queue.empty()) {
+                const int pixel = queue.back();
+                queue.pop_back();
+                const int x = pixel % width, y = pixel / width;
+                pixels++;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                const int neighbors[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+                for (const auto& neighbor : neighbors) {
+                    const int nx = neighbor[0], ny = neighbor[1];
+                    if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                    if (label[ny * width + nx] >= 0 || matrix.get(nx, ny) != value) continue;
+                    label[ny * width + nx] = component;
+                    queue.push_back(ny * width + nx);
+                }
+            }
+            size.push_back(std::min(pixels + 1, 0xFFFF));
+            minPoint.push_back(minY << 16 | minX);
+            maxPoint.push_back(maxY << 16 | maxX);
+        }
+    }
+};
+
+void check_against_reference(Ref<BitMatrix> matrix, Ref<UnicomBlock> block) {
+    const int width = matrix->getWidth();
+    const int height = matrix->getHeight();
+    matrix->isInitRowCounters = false;
+    block->Resize(height, width);
+    block->Reset(matrix);
+    Reference reference(*matrix);
+
+    // every component gets one index, in the order it is first queried
+    std::vector<int> indexOf(reference.size.size(), 0);
+    int nextIndex = 1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int component = reference.label[y * width + x];
+            if (!indexOf[component]) indexOf[component] = nextIndex++;
+            CHECK(block->GetUnicomBlockIndex(y, x) == indexOf[component]);
+            CHECK(block->GetUnicomBlockSize(y, x) == reference.size[component]);
+            int minY = -1, minX = -1, maxY = -1, maxX = -1;
+            CHECK(block->GetMinPoint(y, x, minY, minX) == 0);
+            CHECK(block->GetMaxPoint(y, x, maxY, maxX) == 0);
+            CHECK((minY << 16 | minX) == reference.minPoint[component]);
+            CHECK((maxY << 16 | maxX) == reference.maxPoint[component]);
+        }
+    }
+    int y = 0, x = 0;
+    CHECK(block->GetUnicomBlockSize(height, 0) == 0);
+    CHECK(block->GetMinPoint(0, width, y, x) == -1);
+}
+
+Ref<BitMatrix> new_matrix(int width, int height, BitMatrix::Storage storage) {
+    ErrorHandler err_handler;
+    Ref<BitMatrix> matrix(new BitMatrix(width, height, storage, err_handler));
+    CHECK(err_handler.ErrCode() == 0);
+    return matrix;
+}
+
+}  // namespace
+
+int main() {
+    Ref<UnicomBlock> block(new UnicomBlock(1, 1));
+    block->Init();
+    const BitMatrix::Storage storages[] = {BitMatrix::BYTE_PER_PIXEL, BitMatrix::BIT_PACKED};
+    for (BitMatrix::Storage storage : storages) {
+        // random noise and random blobs of several sizes
+        for (int i = 0; i < 60; i++) {
+            const int width = 1 + int(next_random() % 90);
+            const int height = 1 + int(next_random() % 90);
+            const int density = int(next_random() % 100);
+            const int cell = 1 + int(next_random() % 6);
+            Ref<BitMatrix> matrix = new_matrix(width, height, storage);
+            std::vector<unsigned char> cells((width / cell + 1) * (height / cell + 1));
+            for (auto& value : cells) value = int(next_random() % 100) < density;
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    if (cells[(y / cell) * (width / cell + 1) + x / cell]) matrix->set(x, y);
+                }
+            }
+            check_against_reference(matrix, block);
+
+            // the labels of a matrix carry over to its inverted copy
+            ErrorHandler err_handler;
+            Ref<BitMatrix> inverted = new_matrix(width, height, storage);
+            inverted->invertedCopyOf(matrix, err_handler);
+            CHECK(err_handler.ErrCode() == 0);
+            check_against_reference(inverted, block);
+        }
+
+        // a frame along the borders around a checkerboard, a comb reaching the bottom edge, and
+        // single rows and columns
+        Ref<BitMatrix> frame = new_matrix(67, 41, storage);
+        for (int y = 0; y < 41; y++) {
+            for (int x = 0; x < 67; x++) {
+                bool border = x == 0 || y == 0 || x == 66 || y == 40;
+                if (border || ((x + y) & 1)) frame->set(x, y);
+            }
+        }
+        check_against_reference(frame, block);
+
+        Ref<BitMatrix> comb = new_matrix(64, 30, storage);
+        for (int y = 0; y < 30; y++) {
+            for (int x = 0; x < 64; x++) {
+                if (y == 0 || (x % 3 == 0)) comb->set(x, y);
+            }
+        }
+        check_against_reference(comb, block);
+
+        Ref<BitMatrix> row = new_matrix(130, 1, storage);
+        for (int x = 0; x < 130; x += 1 + int(next_random() % 4)) row->set(x, 0);
+        check_against_reference(row, block);
+
+        Ref<BitMatrix> column = new_matrix(1, 70, storage);
+        for (int y = 0; y < 70; y += 1 + int(next_random() % 4)) column->set(0, y);
+        check_against_reference(column, block);
+
+        // one component larger than the size saturates at
+        Ref<BitMatrix> full = new_matrix(300, 300, storage);
+        check_against_reference(full, block);
+    }
+    return EXIT_SUCCESS;
+}
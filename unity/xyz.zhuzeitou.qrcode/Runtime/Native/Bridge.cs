@@ -58,5 +58,8 @@ namespace ZZT.QRCode.Native
 
         [DllImport(DLLName, EntryPoint = "zzt_qrcode_get_result_points")]
         internal static extern int GetResultPoints(NativeResult result, int index, [Out] float[] pts, ref int ptsLen);
+
+        [DllImport(DLLName, EntryPoint = "zzt_qrcode_export_results")]
+        internal static extern int ExportResults(NativeResult result, [Out] byte[] buf, ref int bufLen);
     }
 }
\ No newline at end of file
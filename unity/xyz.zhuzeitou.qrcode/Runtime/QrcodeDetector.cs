@@ -43,7 +43,15 @@ namespace ZZT.QRCode
             /// <summary>4 channels ARGB</summary>
             ARGB = 5,
             /// <summary>4 channels ABGR</summary>
-            ABGR = 6
+            ABGR = 6,
+            /// <summary>YUV 4:2:0 semi-planar (Y plane then VU), only the Y plane is read</summary>
+            NV21 = 7,
+            /// <summary>YUV 4:2:0 semi-planar (Y plane then UV), only the Y plane is read</summary>
+            NV12 = 8,
+            /// <summary>YUV 4:2:0 planar (Y, U, V planes), only the Y plane is read</summary>
+            I420 = 9,
+            /// <summary>YUV 4:2:0 planar (Y, V, U planes), only the Y plane is read</summary>
+            YV12 = 10
         }
 
         private static readonly Dictionary<TextureFormat, PixelFormat> FormatMap = new()
@@ -67,6 +75,10 @@ namespace ZZT.QRCode
                 case PixelFormat.BGRA: return 4;
                 case PixelFormat.ARGB: return 4;
                 case PixelFormat.ABGR: return 4;
+                case PixelFormat.NV21: return 1;
+                case PixelFormat.NV12: return 1;
+                case PixelFormat.I420: return 1;
+                case PixelFormat.YV12: return 1;
                 default: return 0;
             }
         }
@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Buffers;
+using System.Runtime.InteropServices;
 using ZZT.QRCode.Native;
 
 namespace ZZT.QRCode
@@ -41,12 +42,15 @@ namespace ZZT.QRCode
         {
             /// <summary>Decoded text content.</summary>
             public string Text { get; }
+            /// <summary>Raw data codewords of the QR code.</summary>
+            public byte[] RawBytes { get; }
             /// <summary>Corner points of the QR code.</summary>
             public ResultPoint[] Points { get; }
 
-            internal QrcodeResult(string text, ResultPoint[] points)
+            internal QrcodeResult(string text, byte[] rawBytes, ResultPoint[] points)
             {
                 Text = text;
+                RawBytes = rawBytes;
                 Points = points;
             }
 
@@ -108,6 +112,10 @@ namespace ZZT.QRCode
             return new QrcodeResults(results, ErrorCode.OK);
         }
 
+        // Sizes of zzt_qrcode_export_header_t and zzt_qrcode_export_entry_t.
+        private const int ExportHeaderSize = 2 * sizeof(int);
+        private const int ExportEntrySize = 6 * sizeof(int);
+
         internal static QrcodeResults Parse(Bridge.NativeResult resultPtr, int err)
         {
             if (err != 0)
@@ -115,93 +123,60 @@ namespace ZZT.QRCode
                 return FromErrorCode((ErrorCode)err);
             }
 
-            int resultSize = 0;
-            err = Bridge.GetResultSize(resultPtr, ref resultSize);
-            if (err != 0 || resultSize <= 0)
+            // Fetch every result with one export call instead of querying texts and points one by one.
+            int bufSize = 0;
+            err = Bridge.ExportResults(resultPtr, null, ref bufSize);
+            if (err != 0 || bufSize <= ExportHeaderSize)
             {
                 return FromErrorCode((ErrorCode)err);
             }
 
-            QrcodeResult[] ret = new QrcodeResult[resultSize];
-
-            for (int i = 0; i < resultSize; i++)
+            byte[] buf = ArrayPool<byte>.Shared.Rent(bufSize);
+            try
             {
-                string text = string.Empty;
+                bufSize = buf.Length;
+                err = Bridge.ExportResults(resultPtr, buf, ref bufSize);
+                if (err != 0)
                 {
-                    int bufSize = 0;
-                    err = Bridge.GetResultText(resultPtr, i, null, ref bufSize);
-                    if (err != 0)
-                    {
-                        return FromErrorCode((ErrorCode)err);
-                    }
+                    return FromErrorCode((ErrorCode)err);
+                }
 
-                    if (bufSize > 0)
-                    {
-                        byte[] textBuf = ArrayPool<byte>.Shared.Rent(bufSize);
-                        try
-                        {
-                            bufSize = textBuf.Length;
-                            err = Bridge.GetResultText(resultPtr, i, textBuf, ref bufSize);
-                            if (err != 0)
-                            {
-                                return FromErrorCode((ErrorCode)err);
-                            }
-
-                            if (bufSize > 0)
-                            {
-                                int textLen = bufSize - 1;
-                                text = System.Text.Encoding.UTF8.GetString(textBuf, 0, textLen);
-                            }
-                        }
-                        finally
-                        {
-                            ArrayPool<byte>.Shared.Return(textBuf);
-                        }
-                    }
+                ReadOnlySpan<byte> data = buf.AsSpan(0, bufSize);
+                int resultSize = MemoryMarshal.Read<int>(data.Slice(sizeof(int)));
+                if (resultSize <= 0)
+                {
+                    return FromErrorCode(ErrorCode.OK);
                 }
 
-                ResultPoint[] resultPoints = Array.Empty<ResultPoint>();
+                QrcodeResult[] ret = new QrcodeResult[resultSize];
+                for (int i = 0; i < resultSize; i++)
                 {
-                    int count = 0;
-                    err = Bridge.GetResultPoints(resultPtr, i, null, ref count);
-                    if (err != 0)
+                    ReadOnlySpan<int> entry =
+                        MemoryMarshal.Cast<byte, int>(data.Slice(ExportHeaderSize + i * ExportEntrySize, ExportEntrySize));
+                    int textOffset = entry[0], textSize = entry[1];
+                    int rawOffset = entry[2], rawSize = entry[3];
+                    int pointsOffset = entry[4], pointsCount = entry[5];
+
+                    string text = System.Text.Encoding.UTF8.GetString(buf, textOffset, textSize);
+                    byte[] rawBytes = data.Slice(rawOffset, rawSize).ToArray();
+
+                    ReadOnlySpan<float> points =
+                        MemoryMarshal.Cast<byte, float>(data.Slice(pointsOffset, pointsCount * sizeof(float)));
+                    ResultPoint[] resultPoints = new ResultPoint[pointsCount / 2];
+                    for (int j = 0; j < resultPoints.Length; j++)
                     {
-                        return FromErrorCode((ErrorCode)err);
+                        resultPoints[j] = new ResultPoint(points[j * 2], points[j * 2 + 1]);
                     }
 
-                    if (count > 0)
-                    {
-                        float[] points = ArrayPool<float>.Shared.Rent(count);
-                        try
-                        {
-                            count = points.Length;
-                            err = Bridge.GetResultPoints(resultPtr, i, points, ref count);
-                            if (err != 0)
-                            {
-                                return FromErrorCode((ErrorCode)err);
-                            }
-
-                            if (count > 0)
-                            {
-                                int pointCount = count / 2;
-                                resultPoints = new ResultPoint[pointCount];
-                                for (int j = 0; j < pointCount; j++)
-                                {
-                                    resultPoints[j] = new ResultPoint(points[j * 2], points[j * 2 + 1]);
-                                }
-                            }
-                        }
-                        finally
-                        {
-                            ArrayPool<float>.Shared.Return(points);
-                        }
-                    }
+                    ret[i] = new QrcodeResult(text, rawBytes, resultPoints);
                 }
 
-                ret[i] = new QrcodeResult(text, resultPoints);
+                return FromResults(ret);
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buf);
             }
-
-            return FromResults(ret);
         }
     }
 }
\ No newline at end of file